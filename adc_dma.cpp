@@ -0,0 +1,172 @@
+// adc_dma.cpp
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_idf_version.h>
+
+#include "adc_dma.h"
+#include "adc_kernel.h"
+#include "config.h"
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+#include <esp_adc/adc_continuous.h>
+#define ADC_HAVE_DMA 1
+#define ADC_HAVE_FLUSH (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0))
+#else
+#define ADC_HAVE_DMA 0
+#endif
+
+static SemaphoreHandle_t adcMutex = nullptr;
+static portMUX_TYPE adcMutexInit = portMUX_INITIALIZER_UNLOCKED;
+
+// First use can come from any task (sensor init, dust engine, loop)
+static SemaphoreHandle_t adcMutexHandle() {
+  if (!adcMutex) {
+    SemaphoreHandle_t m = xSemaphoreCreateMutex();
+    portENTER_CRITICAL(&adcMutexInit);
+    if (!adcMutex) {
+      adcMutex = m;
+      m = nullptr;
+    }
+    portEXIT_CRITICAL(&adcMutexInit);
+    if (m) vSemaphoreDelete(m);
+  }
+  return adcMutex;
+}
+
+void adcLock() {
+  xSemaphoreTake(adcMutexHandle(), portMAX_DELAY);
+}
+
+bool adcTryLock() {
+  return xSemaphoreTake(adcMutexHandle(), 0) == pdTRUE;
+}
+
+void adcUnlock() {
+  xSemaphoreGive(adcMutex);
+}
+
+// Raw samples for the current burst; guarded by adcLock()
+static uint16_t rawBuf[ADC_DMA_MAX_RAW];
+
+#if ADC_HAVE_DMA
+// =====================================================================
+// Continuous driver: one handle, reconfigured when the pin changes and
+// started only for the length of a burst
+// =====================================================================
+#define ADC_DMA_FRAME_BYTES 256
+#define ADC_DMA_READ_TIMEOUT_MS 50
+
+static adc_continuous_handle_t dmaHandle = nullptr;
+static int dmaPin = -1;
+static adc_channel_t dmaChannel;
+static bool dmaFailed = false;
+
+static bool dmaConfigure(uint8_t pin) {
+  if (dmaHandle && dmaPin == pin) return true;
+  if (dmaFailed) return false;
+
+  adc_unit_t unit;
+  if (adc_continuous_io_to_channel(pin, &unit, &dmaChannel) != ESP_OK || unit != ADC_UNIT_1) {
+    addLogf("[ADC] GPIO%u is not an ADC1 pin, DMA disabled", pin);
+    dmaFailed = true;
+    return false;
+  }
+
+  if (!dmaHandle) {
+    adc_continuous_handle_cfg_t handleCfg = {};
+    handleCfg.max_store_buf_size = ADC_DMA_MAX_RAW * SOC_ADC_DIGI_RESULT_BYTES * 2;
+    handleCfg.conv_frame_size = ADC_DMA_FRAME_BYTES;
+    if (adc_continuous_new_handle(&handleCfg, &dmaHandle) != ESP_OK) {
+      addLog("[ERROR] ADC DMA handle allocation failed, using analogRead");
+      dmaFailed = true;
+      return false;
+    }
+  }
+
+  adc_digi_pattern_config_t pattern = {};
+  pattern.atten = ADC_ATTEN_DB_11;  // same range as analogRead()
+  pattern.channel = dmaChannel;
+  pattern.unit = ADC_UNIT_1;
+  pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+  adc_continuous_config_t cfg = {};
+  cfg.pattern_num = 1;
+  cfg.adc_pattern = &pattern;
+  cfg.sample_freq_hz = ADC_DMA_SAMPLE_HZ;
+  cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  cfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+
+  if (adc_continuous_config(dmaHandle, &cfg) != ESP_OK) {
+    addLog("[ERROR] ADC DMA config failed, using analogRead");
+    dmaFailed = true;
+    return false;
+  }
+
+  dmaPin = pin;
+  addLogf("[ADC] DMA burst mode on GPIO%u at %u Hz", pin, ADC_DMA_SAMPLE_HZ);
+  return true;
+}
+
+// Blocks (not spinning) until `want` conversions arrive.
+// Conversions run until adc_continuous_stop() and stopping does not empty
+// the driver's pool, so the previous burst's tail is dropped first;
+// otherwise a reading would start with data one sample period old.
+static size_t dmaCapture(size_t want) {
+  uint8_t frame[ADC_DMA_FRAME_BYTES];
+  size_t got = 0;
+  uint32_t len = 0;
+
+#if ADC_HAVE_FLUSH
+  adc_continuous_flush_pool(dmaHandle);
+#endif
+  if (adc_continuous_start(dmaHandle) != ESP_OK) return 0;
+#if !ADC_HAVE_FLUSH
+  // Anything readable right after start is old: a new frame takes
+  // ADC_DMA_FRAME_BYTES / 2 conversions (6.4 ms) to fill
+  while (adc_continuous_read(dmaHandle, frame, sizeof(frame), &len, 0) == ESP_OK) {}
+#endif
+  while (got < want) {
+    if (adc_continuous_read(dmaHandle, frame, sizeof(frame), &len, ADC_DMA_READ_TIMEOUT_MS) != ESP_OK) break;
+    got += adcParseFrames(frame, len, (uint8_t)dmaChannel, rawBuf + got, want - got);
+  }
+  adc_continuous_stop(dmaHandle);
+  return got;
+}
+#endif
+
+bool adcDmaActive() {
+#if ADC_HAVE_DMA
+  return dmaHandle && !dmaFailed;
+#else
+  return false;
+#endif
+}
+
+bool adcReadOversampled(uint8_t pin, uint16_t *out, size_t n, uint8_t factor) {
+  if (factor == 0) factor = 1;
+  if (n * factor > ADC_DMA_MAX_RAW) factor = ADC_DMA_MAX_RAW / n;
+  if (factor == 0) return false;
+
+  adcLock();
+  bool ok = false;
+
+#if ADC_HAVE_DMA
+  if (dmaConfigure(pin)) {
+    size_t want = n * factor;
+    ok = dmaCapture(want) == want && adcDecimate(rawBuf, want, factor, out) == n;
+  }
+#endif
+
+  // One-shot fallback, spaced like the original MQ135 reader
+  if (!ok) {
+    for (size_t i = 0; i < n; i++) {
+      out[i] = analogRead(pin);
+      delayMicroseconds(300);
+    }
+    ok = true;
+  }
+
+  adcUnlock();
+  return ok;
+}
@@ -0,0 +1,26 @@
+// adc_dma.h
+#pragma once
+#include <Arduino.h>
+
+// =====================================================================
+// Oversampled ADC acquisition.
+// On ESP-IDF 5 (Arduino core 3.x) a burst is captured by the continuous
+// (DMA) driver at ADC_DMA_SAMPLE_HZ and decimated with adc_kernel.h; the
+// CPU sleeps while the DMA fills the buffer. Older cores fall back to
+// spaced analogRead() calls.
+//
+// The continuous driver and one-shot reads share ADC1, so every user of
+// the ADC (bursts here, analogRead elsewhere) must hold adcLock().
+// =====================================================================
+#define ADC_DMA_SAMPLE_HZ 20000  // lowest rate the ESP32 DMA mode supports
+#define ADC_DMA_MAX_RAW 256      // raw conversions per burst
+
+void adcLock();
+bool adcTryLock();  // non-blocking, for the dust pulse task
+void adcUnlock();
+
+// Fills out[0..n) with n oversampled readings of pin, each the mean of
+// `factor` raw conversions. Returns false if the burst failed.
+bool adcReadOversampled(uint8_t pin, uint16_t *out, size_t n, uint8_t factor);
+
+bool adcDmaActive();
@@ -0,0 +1,64 @@
+// adc_kernel.h
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// =====================================================================
+// Batch kernels for raw ADC data. Pure functions with no driver calls,
+// so recorded DMA traces can be replayed through them off-target.
+// =====================================================================
+
+// ESP32 DMA output format TYPE1: one little-endian uint16 per conversion,
+// bits 0..11 = raw value, bits 12..15 = ADC1 channel.
+#define ADC_TYPE1_BYTES 2
+#define ADC_TYPE1_DATA_MASK 0x0FFF
+#define ADC_TYPE1_CHANNEL_SHIFT 12
+
+// Extracts the conversions of one channel from a DMA frame.
+// Returns the number of samples written to out (at most max).
+inline size_t adcParseFrames(const uint8_t *bytes, size_t len, uint8_t channel, uint16_t *out, size_t max) {
+  size_t n = 0;
+  for (size_t i = 0; i + ADC_TYPE1_BYTES <= len && n < max; i += ADC_TYPE1_BYTES) {
+    uint16_t word = (uint16_t)(bytes[i] | (bytes[i + 1] << 8));
+    if ((word >> ADC_TYPE1_CHANNEL_SHIFT) != channel) continue;
+    out[n++] = word & ADC_TYPE1_DATA_MASK;
+  }
+  return n;
+}
+
+// Boxcar oversampling: every `factor` inputs become one rounded mean.
+// A trailing partial block is dropped. out may alias in.
+inline size_t adcDecimate(const uint16_t *in, size_t n, uint8_t factor, uint16_t *out) {
+  if (factor <= 1) {
+    for (size_t i = 0; i < n; i++) out[i] = in[i];
+    return n;
+  }
+  size_t blocks = n / factor;
+  for (size_t b = 0; b < blocks; b++) {
+    uint32_t sum = factor / 2;
+    const uint16_t *p = in + b * factor;
+    for (uint8_t k = 0; k < factor; k++) sum += p[k];
+    out[b] = (uint16_t)(sum / factor);
+  }
+  return blocks;
+}
+
+// Mean of the samples left after dropping `trim` from each end (sorts buf)
+inline uint16_t adcTrimmedMean(uint16_t *buf, size_t n, size_t trim) {
+  if (n == 0) return 0;
+  if (2 * trim >= n) trim = (n - 1) / 2;
+
+  for (size_t i = 1; i < n; i++) {
+    uint16_t v = buf[i];
+    size_t j = i;
+    while (j > 0 && buf[j - 1] > v) {
+      buf[j] = buf[j - 1];
+      j--;
+    }
+    buf[j] = v;
+  }
+
+  uint32_t sum = 0;
+  for (size_t i = trim; i < n - trim; i++) sum += buf[i];
+  return (uint16_t)(sum / (n - 2 * trim));
+}
@@ -0,0 +1,100 @@
+// aggregator.cpp
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "aggregator.h"
+#include "config.h"
+#include "stats.h"
+
+// --- Per-channel window state ---
+struct ChannelAggregate {
+  RunningStats stats;
+  P2Quantile p50{ 0.5f };
+  P2Quantile p90{ 0.9f };
+
+  void reset() {
+    stats.reset();
+    p50.reset();
+    p90.reset();
+  }
+
+  void add(float v) {
+    stats.add(v);
+    p50.add(v);
+    p90.add(v);
+  }
+};
+
+static ChannelAggregate channels[CH_COUNT];
+static uint32_t windowSamples = 0;
+static unsigned long windowStart = 0;
+static uint64_t windowLastMono = 0;
+static uint32_t windowLastBoot = 0;
+
+// --- Add one raw sample to the current window ---
+void aggregatorAdd(const SensorSample &s) {
+  if (windowSamples == 0) windowStart = millis();
+
+  for (uint8_t i = 0; i < CH_COUNT; i++) channels[i].add(s.v[i]);
+
+  windowSamples++;
+  windowLastMono = s.mono;
+  windowLastBoot = s.boot;
+}
+
+bool aggregatorDue() {
+  if (windowSamples == 0) return false;
+  return millis() - windowStart >= appConfig.publishWindow * 1000UL;
+}
+
+// --- Summary payload: "<key>" keeps the mean so raw consumers still work ---
+String aggregatorSummaryJson() {
+  StaticJsonDocument<2560> doc;
+  doc["id"] = appConfig.deviceId;
+  doc["type"] = "summary";
+  doc["win"] = (millis() - windowStart) / 1000;
+  doc["n"] = windowSamples;
+
+  char key[16];
+  for (uint8_t i = 0; i < CH_COUNT; i++) {
+    const ChannelAggregate &c = channels[i];
+    if (c.stats.n == 0) continue;
+
+    const char *name = sampleChannels[i].key;
+    int dec = sampleChannels[i].decimals;
+    int decEst = dec < 1 ? 1 : dec;
+
+    doc[name] = safeRound(c.stats.average(), decEst);
+
+    snprintf(key, sizeof(key), "%s_min", name);
+    doc[key] = safeRound(c.stats.min, dec);
+    snprintf(key, sizeof(key), "%s_max", name);
+    doc[key] = safeRound(c.stats.max, dec);
+
+    float sd = c.stats.stddev();
+    if (isfinite(sd)) {
+      snprintf(key, sizeof(key), "%s_sd", name);
+      doc[key] = safeRound(sd, decEst + 1);
+    }
+
+    snprintf(key, sizeof(key), "%s_p50", name);
+    doc[key] = safeRound(c.p50.value(), decEst);
+    snprintf(key, sizeof(key), "%s_p90", name);
+    doc[key] = safeRound(c.p90.value(), decEst);
+  }
+
+  addSampleTime(doc, windowLastBoot, windowLastMono);
+
+  String json;
+  serializeJson(doc, json);
+
+  addLogf("[AGG] Window closed: %u samples over %lus", windowSamples, (millis() - windowStart) / 1000);
+
+  aggregatorReset();
+  return json;
+}
+
+void aggregatorReset() {
+  for (uint8_t i = 0; i < CH_COUNT; i++) channels[i].reset();
+  windowSamples = 0;
+}
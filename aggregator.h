@@ -0,0 +1,12 @@
+// aggregator.h
+#pragma once
+#include <Arduino.h>
+#include "data.h"
+
+// Windowed per-channel statistics for low-rate upstream publishing.
+// Samples are added at the local rate (sendInterval); a summary is
+// produced once every appConfig.publishWindow seconds.
+void aggregatorAdd(const SensorSample &s);
+bool aggregatorDue();
+String aggregatorSummaryJson();  // builds the summary and starts a new window
+void aggregatorReset();          // drops the current window
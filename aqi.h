@@ -0,0 +1,197 @@
+// aqi.h
+#pragma once
+#include <math.h>
+#include <stdint.h>
+
+// =====================================================================
+// Multi-standard AQI with an incremental NowCast.
+// Pure logic, no hardware access.
+// =====================================================================
+
+enum AqiStandard : uint8_t { AQI_US_EPA, AQI_VN, AQI_CN, AQI_STANDARD_COUNT };
+enum AqiPollutant : uint8_t { AQI_PM25, AQI_PM10, AQI_POLLUTANT_COUNT };
+
+// One band: I = iLo + (iHi - iLo) * (C - cLo) / (cHi - cLo), µg/m³
+struct AqiBreakpoint {
+  float cLo, cHi;
+  uint16_t iLo, iHi;
+};
+
+struct AqiTable {
+  const AqiBreakpoint *bp;
+  uint8_t n;
+  float resolution;  // concentrations are truncated to this first (0 = none)
+};
+
+// US EPA (40 CFR 58 App. G, 2012 PM2.5 table)
+static constexpr AqiBreakpoint AQI_BP_US_PM25[] = {
+  { 0.0f, 12.0f, 0, 50 }, { 12.1f, 35.4f, 51, 100 }, { 35.5f, 55.4f, 101, 150 }, { 55.5f, 150.4f, 151, 200 },
+  { 150.5f, 250.4f, 201, 300 }, { 250.5f, 350.4f, 301, 400 }, { 350.5f, 500.4f, 401, 500 },
+};
+static constexpr AqiBreakpoint AQI_BP_US_PM10[] = {
+  { 0, 54, 0, 50 }, { 55, 154, 51, 100 }, { 155, 254, 101, 150 }, { 255, 354, 151, 200 },
+  { 355, 424, 201, 300 }, { 425, 504, 301, 400 }, { 505, 604, 401, 500 },
+};
+
+// Vietnam VN_AQI (QD 1459/QD-TCMT, 2019)
+static constexpr AqiBreakpoint AQI_BP_VN_PM25[] = {
+  { 0, 25, 0, 50 }, { 25, 50, 50, 100 }, { 50, 80, 100, 150 }, { 80, 150, 150, 200 },
+  { 150, 250, 200, 300 }, { 250, 350, 300, 400 }, { 350, 500, 400, 500 },
+};
+static constexpr AqiBreakpoint AQI_BP_VN_PM10[] = {
+  { 0, 50, 0, 50 }, { 50, 150, 50, 100 }, { 150, 250, 100, 150 }, { 250, 350, 150, 200 },
+  { 350, 420, 200, 300 }, { 420, 500, 300, 400 }, { 500, 600, 400, 500 },
+};
+
+// China IAQI (HJ 633-2012)
+static constexpr AqiBreakpoint AQI_BP_CN_PM25[] = {
+  { 0, 35, 0, 50 }, { 35, 75, 50, 100 }, { 75, 115, 100, 150 }, { 115, 150, 150, 200 },
+  { 150, 250, 200, 300 }, { 250, 350, 300, 400 }, { 350, 500, 400, 500 },
+};
+static constexpr AqiBreakpoint AQI_BP_CN_PM10[] = {
+  { 0, 50, 0, 50 }, { 50, 150, 50, 100 }, { 150, 250, 100, 150 }, { 250, 350, 150, 200 },
+  { 350, 420, 200, 300 }, { 420, 500, 300, 400 }, { 500, 600, 400, 500 },
+};
+
+#define AQI_TABLE(t, res) { t, sizeof(t) / sizeof(t[0]), res }
+
+static constexpr AqiTable AQI_TABLES[AQI_STANDARD_COUNT][AQI_POLLUTANT_COUNT] = {
+  { AQI_TABLE(AQI_BP_US_PM25, 0.1f), AQI_TABLE(AQI_BP_US_PM10, 1.0f) },
+  { AQI_TABLE(AQI_BP_VN_PM25, 0.0f), AQI_TABLE(AQI_BP_VN_PM10, 0.0f) },
+  { AQI_TABLE(AQI_BP_CN_PM25, 0.0f), AQI_TABLE(AQI_BP_CN_PM10, 0.0f) },
+};
+
+// -1 if c is invalid; capped at the top of the table
+inline int aqiSubIndex(const AqiTable &t, float c) {
+  if (!isfinite(c) || c < 0.0f) return -1;
+  if (t.resolution > 0.0f) c = floorf(c / t.resolution + 1e-3f) * t.resolution;
+  for (uint8_t i = 0; i < t.n; i++) {
+    const AqiBreakpoint &b = t.bp[i];
+    if (c <= b.cHi) return (int)roundf(b.iLo + (b.iHi - b.iLo) * (c - b.cLo) / (b.cHi - b.cLo));
+  }
+  return t.bp[t.n - 1].iHi;
+}
+
+inline int aqiSubIndex(AqiStandard std, AqiPollutant p, float c) {
+  return std < AQI_STANDARD_COUNT ? aqiSubIndex(AQI_TABLES[std][p], c) : -1;
+}
+
+// ---------------------------------------------------------------------
+// NowCast (EPA): c1 is the current hour, c12 eleven hours back.
+// w = max(min / max, 0.5) over the valid hours, NowCast = sum(w^(i-1) ci)
+// / sum(w^(i-1)), valid when 2 of the 3 most recent hours have data.
+// Samples land in hourly sum/count buckets (O(1) per sample); the ring
+// advances one slot per hour, so evaluation is a fixed 12-term pass
+// and raw history is never kept. Zero-initialised state is empty, so an
+// instance can live in RTC memory across deep sleep.
+// ---------------------------------------------------------------------
+#define AQI_NOWCAST_HOURS 12
+#define AQI_HOUR_US 3600000000ULL
+#define AQI_NOWCAST_MIN_WEIGHT 0.5f
+
+struct NowCast {
+  struct Bucket {
+    float sum;
+    uint16_t n;
+  };
+
+  Bucket hours[AQI_NOWCAST_HOURS];
+  uint32_t hourKey;  // hour number of hours[head] + 1 (0 = empty)
+  uint8_t head;
+
+  void reset() {
+    for (uint8_t i = 0; i < AQI_NOWCAST_HOURS; i++) hours[i] = { 0.0f, 0 };
+    hourKey = 0;
+    head = 0;
+  }
+
+  // hour: any monotonic hour number, e.g. mono µs / 3.6e9
+  void add(uint32_t hour, float c) {
+    advance(hour);
+    if (!isfinite(c) || c < 0.0f) return;
+    hours[head].sum += c;
+    hours[head].n++;
+  }
+
+  // NAN until enough recent hours have data
+  float value() const {
+    if (hourKey == 0) return NAN;
+
+    uint8_t recent = 0;
+    float lo = INFINITY, hi = 0.0f;
+    for (uint8_t i = 0; i < AQI_NOWCAST_HOURS; i++) {
+      const Bucket &b = at(i);
+      if (b.n == 0) continue;
+      if (i < 3) recent++;
+      float c = b.sum / b.n;
+      if (c < lo) lo = c;
+      if (c > hi) hi = c;
+    }
+    if (recent < 2) return NAN;
+
+    float w = hi > 0.0f ? lo / hi : 1.0f;
+    if (w < AQI_NOWCAST_MIN_WEIGHT) w = AQI_NOWCAST_MIN_WEIGHT;
+
+    float num = 0.0f, den = 0.0f, wi = 1.0f;
+    for (uint8_t i = 0; i < AQI_NOWCAST_HOURS; i++, wi *= w) {
+      const Bucket &b = at(i);
+      if (b.n == 0) continue;
+      num += wi * (b.sum / b.n);
+      den += wi;
+    }
+    return num / den;
+  }
+
+private:
+  const Bucket &at(uint8_t ago) const {
+    return hours[(head + AQI_NOWCAST_HOURS - ago) % AQI_NOWCAST_HOURS];
+  }
+
+  void advance(uint32_t hour) {
+    uint32_t key = hour + 1;
+    if (hourKey == 0 || key < hourKey || key - hourKey >= AQI_NOWCAST_HOURS) {
+      reset();  // first use, clock restarted, or a 12 h gap
+      hourKey = key;
+      return;
+    }
+    while (hourKey < key) {
+      head = (head + 1) % AQI_NOWCAST_HOURS;
+      hours[head] = { 0.0f, 0 };
+      hourKey++;
+    }
+  }
+};
+
+// ---------------------------------------------------------------------
+// Overall AQI: the worst sub-index. PM goes through NowCast; other
+// pollutants (e.g. a calibrated gas sensor) supply their own sub-index.
+// ---------------------------------------------------------------------
+struct AqiEngine {
+  NowCast pm[AQI_POLLUTANT_COUNT];
+  int16_t gas;  // external sub-index, <= 0 = none
+
+  void addPm(AqiPollutant p, uint32_t hour, float c) { pm[p].add(hour, c); }
+  void setGasSubIndex(int index) { gas = index; }
+
+  int subIndex(AqiStandard std, AqiPollutant p) const { return aqiSubIndex(std, p, pm[p].value()); }
+
+  // -1 if nothing is valid yet; dominant receives the winning pollutant
+  // (AQI_POLLUTANT_COUNT for the gas hook)
+  int overall(AqiStandard std, uint8_t *dominant = nullptr) const {
+    int best = -1;
+    uint8_t who = AQI_POLLUTANT_COUNT;
+    for (uint8_t p = 0; p < AQI_POLLUTANT_COUNT; p++) {
+      int i = subIndex(std, (AqiPollutant)p);
+      if (i > best) {
+        best = i;
+        who = p;
+      }
+    }
+    if (gas > 0 && gas > best) {
+      best = gas;
+      who = AQI_POLLUTANT_COUNT;
+    }
+    if (dominant) *dominant = who;
+    return best;
+  }
+};
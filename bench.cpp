@@ -0,0 +1,272 @@
+// bench.cpp
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <SPIFFS.h>
+
+#include "bench.h"
+#include "data.h"
+#include "aqi.h"
+#include "timebase.h"
+#include "file_queue.h"
+#include "mq135.h"
+
+#if defined(CONFIG_HEAP_TRACING_STANDALONE)
+#include <esp_heap_trace.h>
+#define BENCH_TRACE_RECORDS 256
+static heap_trace_record_t traceRecords[BENCH_TRACE_RECORDS];
+static bool traceReady = false;
+#endif
+
+// Scratch queue, so the live one is not touched
+static FileQueue benchQueue(SPIFFS, "/bq");
+
+typedef void (*BenchFn)(uint32_t iterations);
+
+// =====================================================================
+// Harness
+// =====================================================================
+static void countAllocs(BenchFn fn, uint32_t iterations, BenchResult &r) {
+  r.allocsPerOp = -1;
+  r.bytesPerOp = -1;
+#if defined(CONFIG_HEAP_TRACING_STANDALONE)
+  if (!traceReady) traceReady = heap_trace_init_standalone(traceRecords, BENCH_TRACE_RECORDS) == ESP_OK;
+  if (!traceReady || heap_trace_start(HEAP_TRACE_ALL) != ESP_OK) return;
+  fn(iterations);
+  heap_trace_stop();
+
+  // Other tasks allocate too, so this is an upper bound
+  size_t count = heap_trace_get_count();
+  if (count >= BENCH_TRACE_RECORDS) return;  // overflowed, not trustworthy
+  uint32_t bytes = 0;
+  for (size_t i = 0; i < count; i++) {
+    heap_trace_record_t rec;
+    if (heap_trace_get(i, &rec) == ESP_OK) bytes += rec.size;
+  }
+  r.allocsPerOp = (count + iterations / 2) / iterations;
+  r.bytesPerOp = (bytes + iterations / 2) / iterations;
+#endif
+}
+
+static BenchResult runBench(const char *name, BenchFn fn, uint32_t iterations) {
+  BenchResult r = { name, iterations, 0.0f, -1, -1 };
+
+  fn(1);  // warm caches, lazy init
+
+  uint32_t start = ESP.getCycleCount();
+  fn(iterations);
+  uint32_t cycles = ESP.getCycleCount() - start;
+  r.nsPerOp = cycles * 1000.0f / ESP.getCpuFreqMHz() / iterations;
+
+  countAllocs(fn, iterations, r);
+  return r;
+}
+
+// =====================================================================
+// Cases. Inputs are a typical mid-range reading.
+// =====================================================================
+static SensorSample benchSample() {
+  SensorSample s;
+  for (uint8_t i = 0; i < CH_COUNT; i++) s.v[i] = NAN;
+  s.v[CH_T] = 28.5f;
+  s.v[CH_H] = 65.2f;
+  s.v[CH_P] = 1012.3f;
+  s.v[CH_PM] = 35.0f;
+  s.v[CH_PM_SD] = 4.7f;
+  s.v[CH_AQI] = 99.0f;
+  s.v[CH_MQ] = 450.0f;
+  s.spikes = 0;
+  s.boot = bootId();
+  s.mono = monoMicros();
+  return s;
+}
+
+// getDataJson() without the sensor I/O: serialization + derived fields
+static void benchSampleJson(uint32_t n) {
+  SensorSample s = benchSample();
+  for (uint32_t i = 0; i < n; i++) {
+    deriveMetrics(s);
+    String json = sampleToJson(s);
+  }
+}
+
+// Replaces calcAQI_PM25: bucket update plus NowCast in the configured scale
+static void benchAqi(uint32_t n) {
+  static AqiEngine engine;
+  AqiStandard std = (AqiStandard)appConfig.aqiStandard;
+  volatile int sink = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    engine.addPm(AQI_PM25, i / 64, 20.0f + (i % 31));
+    sink = sink + engine.overall(std);
+  }
+}
+
+// Hourly bucket update alone, the part of aqi_nowcast that runs every sample
+static void benchAqiAdd(uint32_t n) {
+  static AqiEngine engine;
+  for (uint32_t i = 0; i < n; i++) engine.addPm(AQI_PM25, i / 100, 5.0f + (i % 97));
+}
+
+// Includes the oversampled ADC burst, which dominates
+static void benchMq135(uint32_t n) {
+  if (!mq135) return;
+  volatile float sink = 0;
+  for (uint32_t i = 0; i < n; i++) sink = sink + mq135->getCorrectedIndex(28.5f, 65.2f);
+}
+
+// Gas index power curve over ratios 0.05 .. 20 (clean air is ~1)
+#define CURVE_POINTS 1000
+
+static float curveRatio(uint32_t i) {
+  return 0.05f + (i % CURVE_POINTS) * 0.02f;
+}
+
+static void benchCurvePowf(uint32_t n) {
+  volatile float sink = 0;
+  for (uint32_t i = 0; i < n; i++) sink = sink + MQ135::curveReference(curveRatio(i));
+}
+
+static void benchCurveTable(uint32_t n) {
+  volatile float sink = 0;
+  for (uint32_t i = 0; i < n; i++) sink = sink + MQ135::curve(curveRatio(i));
+}
+
+static float curveMaxRelError() {
+  float maxErr = 0;
+  for (uint32_t i = 0; i < CURVE_POINTS; i++) {
+    float r = curveRatio(i);
+    float err = fabsf(MQ135::curve(r) / MQ135::curveReference(r) - 1.0f);
+    if (err > maxErr) maxErr = err;
+  }
+  return maxErr;
+}
+
+// appendToQueue's flash path (RAM slots are a String copy)
+static void benchQueueAppend(uint32_t n) {
+  String json = sampleToJson(benchSample());
+  for (uint32_t i = 0; i < n; i++) benchQueue.append(json);
+}
+
+static bool benchPublish(const String &record) {
+  String out = fixupTimestamp(record);
+  return out.length() > 0;
+}
+
+// sendQueue's per-record work: read a line back, resolve its timestamp and
+// advance the cursor. The publish itself is network-bound and left out.
+static void benchQueueDrain(uint32_t n) {
+  benchQueue.drain(benchPublish, n);
+}
+
+// Full path: Serial, log ring and WebSocket broadcast
+static void benchAddLog(uint32_t n) {
+  for (uint32_t i = 0; i < n; i++) addLog("[BENCH] addLog");
+}
+
+// =====================================================================
+// Report
+// =====================================================================
+static void addResult(JsonArray results, const BenchResult &r) {
+  JsonObject o = results.createNestedObject();
+  o["name"] = r.name;
+  o["iterations"] = r.iterations;
+  o["ns_per_op"] = (uint32_t)lroundf(r.nsPerOp);
+  o["allocs_per_op"] = r.allocsPerOp;
+  o["bytes_per_op"] = r.bytesPerOp;
+}
+
+void benchRunAll(JsonObject out) {
+  out["build"] = __DATE__ " " __TIME__;
+  out["sdk"] = ESP.getSdkVersion();
+  out["cpu_mhz"] = ESP.getCpuFreqMHz();
+
+  JsonArray results = out.createNestedArray("results");
+  addResult(results, runBench("sample_json", benchSampleJson, 200));
+  addResult(results, runBench("aqi_bucket_add", benchAqiAdd, 1000));
+  addResult(results, runBench("aqi_nowcast", benchAqi, 1000));
+  if (mq135) addResult(results, runBench("mq135_corrected_index", benchMq135, 10));
+  addResult(results, runBench("mq135_curve_powf", benchCurvePowf, CURVE_POINTS));
+  addResult(results, runBench("mq135_curve_table", benchCurveTable, CURVE_POINTS));
+  out["mq135_curve_max_rel_err"] = curveMaxRelError();
+
+  if (SPIFFS.begin() && benchQueue.begin()) {
+    addResult(results, runBench("queue_append_spiffs", benchQueueAppend, 20));
+    addResult(results, runBench("queue_drain_record", benchQueueDrain, 20));
+    out["queue_write_amplification"] = benchQueue.writeAmplification();
+    benchQueue.drain(benchPublish);
+    benchQueue.erase();
+  }
+
+  addResult(results, runBench("add_log", benchAddLog, 8));
+}
+
+// =====================================================================
+// Runner. The suite takes about a second and writes flash, so it runs in
+// its own task, started by POST /api/bench. GET returns the last report.
+// The 2 KB copy in and out of lastReport is under a mutex, not a critical
+// section, so interrupts stay enabled while it runs.
+// =====================================================================
+#define BENCH_JSON_MAX 2048
+
+static char lastReport[BENCH_JSON_MAX] = "";
+static SemaphoreHandle_t reportLock = nullptr;  // created in setupBenchRoutes()
+static volatile bool benchRunning = false;
+
+static void benchTask(void *) {
+  static char report[BENCH_JSON_MAX];
+  unsigned long start = millis();
+  {
+    StaticJsonDocument<2048> doc;
+    benchRunAll(doc.to<JsonObject>());
+    if (serializeJson(doc, report, sizeof(report)) >= sizeof(report) - 1) {
+      addLog("[BENCH] Report truncated, not stored");
+      report[0] = '\0';
+    }
+  }
+
+  if (report[0]) {
+    xSemaphoreTake(reportLock, portMAX_DELAY);
+    memcpy(lastReport, report, sizeof(lastReport));
+    xSemaphoreGive(reportLock);
+    addLogf("[BENCH] Suite finished in %lu ms", millis() - start);
+  }
+
+  benchRunning = false;
+  vTaskDelete(NULL);
+}
+
+bool benchStart() {
+  if (benchRunning || !reportLock) return false;
+  benchRunning = true;
+  if (xTaskCreate(benchTask, "BenchTask", 8192, NULL, 1, NULL) != pdPASS) {
+    benchRunning = false;
+    return false;
+  }
+  return true;
+}
+
+void setupBenchRoutes() {
+  if (!reportLock) reportLock = xSemaphoreCreateMutex();
+
+  server.on("/api/bench", HTTP_GET, [](AsyncWebServerRequest *request) {
+    char json[BENCH_JSON_MAX];
+    json[0] = '\0';
+    if (reportLock && xSemaphoreTake(reportLock, portMAX_DELAY) == pdTRUE) {
+      memcpy(json, lastReport, sizeof(json));
+      xSemaphoreGive(reportLock);
+    }
+
+    if (!json[0]) {
+      request->send(404, "text/plain", benchRunning ? "Benchmark running" : "No benchmark run yet, POST /api/bench");
+      return;
+    }
+    request->send(200, "application/json", json);
+  });
+
+  server.on("/api/bench", HTTP_POST, [](AsyncWebServerRequest *request) {
+    if (!benchStart()) {
+      request->send(409, "text/plain", "Benchmark already running");
+      return;
+    }
+    request->send(202, "text/plain", "Benchmark started");
+  });
+}
@@ -0,0 +1,27 @@
+// bench.h
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// =====================================================================
+// On-device microbenchmarks for the firmware hot paths.
+// Each case runs a warm-up call, a timed pass (CPU cycle counter) and,
+// when the IDF is built with standalone heap tracing, a traced pass that
+// counts allocations. Without heap tracing the allocation fields are -1.
+// POST /api/bench starts a run in a background task; GET /api/bench
+// returns the last finished report, keyed by build. Save reports from two
+// commits and diff them with tools/bench_compare.py. test/bench_host.cpp
+// runs the hardware-independent cases on the host in the same format.
+// =====================================================================
+
+struct BenchResult {
+  const char *name;
+  uint32_t iterations;
+  float nsPerOp;
+  int32_t allocsPerOp;  // -1 = not measured
+  int32_t bytesPerOp;
+};
+
+void benchRunAll(JsonObject out);  // blocks for about a second
+bool benchStart();                 // false if a run is already in progress
+void setupBenchRoutes();
@@ -0,0 +1,229 @@
+// bme280.cpp
+#include <Arduino.h>
+#include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "bme280.h"
+
+#define REG_CALIB_TP 0x88  // 24 bytes: T1..P9
+#define REG_CALIB_H1 0xA1
+#define REG_CHIP_ID 0xD0
+#define REG_RESET 0xE0
+#define REG_CALIB_H2 0xE1  // 7 bytes: H2..H6
+#define REG_CTRL_HUM 0xF2
+#define REG_STATUS 0xF3
+#define REG_CTRL_MEAS 0xF4
+#define REG_CONFIG 0xF5
+#define REG_DATA 0xF7  // 8 bytes: press[3] temp[3] hum[2]
+
+#define MODE_FORCED 0x01
+#define STATUS_IM_UPDATE 0x01
+#define SKIPPED_20BIT 0x80000
+#define SKIPPED_16BIT 0x8000
+
+// =====================================================================
+// Bus helpers
+// =====================================================================
+bool Bme280::readRegs(uint8_t reg, uint8_t *buf, uint8_t len) {
+  _wire->beginTransmission(_addr);
+  _wire->write(reg);
+  if (_wire->endTransmission(false) != 0) return false;
+  if (_wire->requestFrom(_addr, len) != len) return false;
+  for (uint8_t i = 0; i < len; i++) buf[i] = _wire->read();
+  return true;
+}
+
+bool Bme280::writeReg(uint8_t reg, uint8_t value) {
+  _wire->beginTransmission(_addr);
+  _wire->write(reg);
+  _wire->write(value);
+  return _wire->endTransmission() == 0;
+}
+
+static inline uint16_t le16(const uint8_t *b) { return b[0] | (b[1] << 8); }
+
+static uint8_t osCount(uint8_t code) { return code ? 1 << (code - 1) : 0; }
+
+// =====================================================================
+// Setup
+// =====================================================================
+bool Bme280::readCalibration() {
+  uint8_t b[24];
+  if (!readRegs(REG_CALIB_TP, b, 24)) return false;
+  _cal.T1 = le16(b);
+  _cal.T2 = (int16_t)le16(b + 2);
+  _cal.T3 = (int16_t)le16(b + 4);
+  _cal.P1 = le16(b + 6);
+  _cal.P2 = (int16_t)le16(b + 8);
+  _cal.P3 = (int16_t)le16(b + 10);
+  _cal.P4 = (int16_t)le16(b + 12);
+  _cal.P5 = (int16_t)le16(b + 14);
+  _cal.P6 = (int16_t)le16(b + 16);
+  _cal.P7 = (int16_t)le16(b + 18);
+  _cal.P8 = (int16_t)le16(b + 20);
+  _cal.P9 = (int16_t)le16(b + 22);
+
+  if (!readRegs(REG_CALIB_H1, &_cal.H1, 1)) return false;
+  if (!readRegs(REG_CALIB_H2, b, 7)) return false;
+  _cal.H2 = (int16_t)le16(b);
+  _cal.H3 = b[2];
+  _cal.H4 = (int16_t)(((int8_t)b[3] << 4) | (b[4] & 0x0F));
+  _cal.H5 = (int16_t)(((int8_t)b[5] << 4) | (b[4] >> 4));
+  _cal.H6 = (int8_t)b[6];
+  return true;
+}
+
+bool Bme280::begin(uint8_t addr, TwoWire &wire) {
+  _wire = &wire;
+  _addr = addr;
+  _wire->begin();
+  _wire->setClock(BME280_I2C_HZ);
+
+  uint8_t id = 0;
+  if (!readRegs(REG_CHIP_ID, &id, 1) || id != BME280_CHIP_ID) return false;
+
+  writeReg(REG_RESET, 0xB6);
+  delay(2);
+  uint8_t status = STATUS_IM_UPDATE;
+  for (uint8_t i = 0; i < 10 && (status & STATUS_IM_UPDATE); i++) {
+    delay(1);
+    if (!readRegs(REG_STATUS, &status, 1)) return false;
+  }
+  if (!readCalibration()) return false;
+
+  if (!_lock) _lock = xSemaphoreCreateMutex();
+  configure(BME280_OS_X1, BME280_OS_X1, BME280_OS_X1, BME280_FILTER_OFF);
+  return true;
+}
+
+void Bme280::configure(uint8_t osT, uint8_t osP, uint8_t osH, uint8_t filter) {
+  if (osT == BME280_OS_SKIP) osT = BME280_OS_X1;
+  osT = min<uint8_t>(osT, BME280_OS_X16);
+  osP = min<uint8_t>(osP, BME280_OS_X16);
+  osH = min<uint8_t>(osH, BME280_OS_X16);
+  filter = min<uint8_t>(filter, BME280_FILTER_16);
+
+  xSemaphoreTake(_lock, portMAX_DELAY);
+
+  // config is only written reliably in sleep mode
+  while (_pending && micros() - _triggeredAt < _convUs) delay(1);
+  _pending = false;
+
+  writeReg(REG_CONFIG, filter << 2);
+  writeReg(REG_CTRL_HUM, osH);  // latched by the ctrl_meas write below
+  _ctrlMeas = (osT << 5) | (osP << 2);
+  writeReg(REG_CTRL_MEAS, _ctrlMeas);
+  _osP = osP;
+  _osH = osH;
+
+  uint32_t t = osCount(osT), p = osCount(osP), h = osCount(osH);
+  _convUs = 1250 + 2300 * t + (p ? 2300 * p + 575 : 0) + (h ? 2300 * h + 575 : 0);
+
+  xSemaphoreGive(_lock);
+}
+
+// =====================================================================
+// Acquisition
+// =====================================================================
+bool Bme280::triggerLocked() {
+  if (_pending) return true;
+  uint32_t t0 = micros();
+  if (!writeReg(REG_CTRL_MEAS, _ctrlMeas | MODE_FORCED)) return false;
+  _triggeredAt = micros();
+  _triggerBusUs = _triggeredAt - t0;
+  _pending = true;
+  return true;
+}
+
+bool Bme280::trigger() {
+  if (!_lock) return false;
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  bool ok = triggerLocked();
+  xSemaphoreGive(_lock);
+  return ok;
+}
+
+bool Bme280::read(Bme280Reading &out) {
+  out.temperature = out.humidity = out.pressure = NAN;
+  if (!_lock) return false;
+
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  if (!triggerLocked()) {
+    xSemaphoreGive(_lock);
+    return false;
+  }
+
+  uint32_t waited = micros() - _triggeredAt;
+  if (waited < _convUs) {
+    uint32_t left = _convUs - waited;
+    if (left >= 1000) delay(left / 1000);
+    delayMicroseconds(left % 1000);
+  }
+
+  uint8_t b[8];
+  uint32_t t0 = micros();
+  bool ok = readRegs(REG_DATA, b, 8);
+  uint32_t done = micros();
+  _pending = false;
+
+  if (ok) {
+    _bus.add((float)(_triggerBusUs + done - t0));
+    _latency.add((float)(done - _triggeredAt));
+  }
+  xSemaphoreGive(_lock);
+  if (!ok) return false;
+
+  int32_t adcP = ((uint32_t)b[0] << 12) | ((uint32_t)b[1] << 4) | (b[2] >> 4);
+  int32_t adcT = ((uint32_t)b[3] << 12) | ((uint32_t)b[4] << 4) | (b[5] >> 4);
+  int32_t adcH = ((uint32_t)b[6] << 8) | b[7];
+  if (adcT == SKIPPED_20BIT) return false;
+
+  int32_t tFine;
+  out.temperature = compensateT(adcT, tFine) / 100.0f;
+  if (_osP && adcP != SKIPPED_20BIT) out.pressure = compensateP(adcP, tFine) / 25600.0f;  // Q24.8 Pa -> hPa
+  if (_osH && adcH != SKIPPED_16BIT) out.humidity = compensateH(adcH, tFine) / 1024.0f;
+  return true;
+}
+
+// =====================================================================
+// Compensation (BME280 datasheet 4.2.3)
+// =====================================================================
+// 0.01 °C
+int32_t Bme280::compensateT(int32_t adcT, int32_t &tFine) const {
+  int32_t var1 = ((((adcT >> 3) - ((int32_t)_cal.T1 << 1))) * ((int32_t)_cal.T2)) >> 11;
+  int32_t var2 = (((((adcT >> 4) - ((int32_t)_cal.T1)) * ((adcT >> 4) - ((int32_t)_cal.T1))) >> 12) *
+                  ((int32_t)_cal.T3)) >> 14;
+  tFine = var1 + var2;
+  return (tFine * 5 + 128) >> 8;
+}
+
+// Pa in Q24.8
+uint32_t Bme280::compensateP(int32_t adcP, int32_t tFine) const {
+  int64_t var1 = (int64_t)tFine - 128000;
+  int64_t var2 = var1 * var1 * (int64_t)_cal.P6;
+  var2 = var2 + ((var1 * (int64_t)_cal.P5) << 17);
+  var2 = var2 + (((int64_t)_cal.P4) << 35);
+  var1 = ((var1 * var1 * (int64_t)_cal.P3) >> 8) + ((var1 * (int64_t)_cal.P2) << 12);
+  var1 = ((((int64_t)1) << 47) + var1) * ((int64_t)_cal.P1) >> 33;
+  if (var1 == 0) return 0;
+
+  int64_t p = 1048576 - adcP;
+  p = (((p << 31) - var2) * 3125) / var1;
+  var1 = (((int64_t)_cal.P9) * (p >> 13) * (p >> 13)) >> 25;
+  var2 = (((int64_t)_cal.P8) * p) >> 19;
+  p = ((p + var1 + var2) >> 8) + (((int64_t)_cal.P7) << 4);
+  return (uint32_t)p;
+}
+
+// %RH in Q22.10
+uint32_t Bme280::compensateH(int32_t adcH, int32_t tFine) const {
+  int32_t v = tFine - ((int32_t)76800);
+  v = (((((adcH << 14) - (((int32_t)_cal.H4) << 20) - (((int32_t)_cal.H5) * v)) + ((int32_t)16384)) >> 15) *
+       (((((((v * ((int32_t)_cal.H6)) >> 10) * (((v * ((int32_t)_cal.H3)) >> 11) + ((int32_t)32768))) >> 10) +
+          ((int32_t)2097152)) * ((int32_t)_cal.H2) + 8192) >> 14));
+  v = v - (((((v >> 15) * (v >> 15)) >> 7) * ((int32_t)_cal.H1)) >> 4);
+  v = v < 0 ? 0 : v;
+  v = v > 419430400 ? 419430400 : v;
+  return (uint32_t)(v >> 12);
+}
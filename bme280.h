@@ -0,0 +1,90 @@
+// bme280.h
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "stats.h"
+
+// =====================================================================
+// Register-level BME280 driver, forced mode only.
+// trigger() starts one conversion; read() waits out the datasheet
+// worst-case conversion time, fetches press/temp/hum (0xF7..0xFE) in a
+// single 8-byte burst and compensates all three from one t_fine using
+// the datasheet integer formulas. Call trigger() one conversion time
+// ahead of the sample and read() returns without waiting.
+// =====================================================================
+#define BME280_ADDR 0x76
+#define BME280_CHIP_ID 0x60
+#define BME280_I2C_HZ 400000
+
+// Oversampling codes (ctrl_meas / ctrl_hum)
+#define BME280_OS_SKIP 0
+#define BME280_OS_X1 1
+#define BME280_OS_X2 2
+#define BME280_OS_X4 3
+#define BME280_OS_X8 4
+#define BME280_OS_X16 5
+
+// IIR filter codes (config): off, 2, 4, 8, 16
+#define BME280_FILTER_OFF 0
+#define BME280_FILTER_16 4
+
+struct Bme280Reading {
+  float temperature;  // °C
+  float humidity;     // %RH, NAN if skipped
+  float pressure;     // hPa, NAN if skipped
+};
+
+class Bme280 {
+public:
+  bool begin(uint8_t addr = BME280_ADDR, TwoWire &wire = Wire);
+
+  // Oversampling as BME280_OS_* (temperature cannot be skipped, it
+  // feeds t_fine), filter as a 0..4 code. Waits for a pending conversion.
+  void configure(uint8_t osT, uint8_t osP, uint8_t osH, uint8_t filter);
+
+  bool trigger();  // no-op if a conversion is already pending
+  bool pending() const { return _pending; }
+  bool read(Bme280Reading &out);
+
+  // Worst-case conversion time for the current settings (datasheet 9.1)
+  uint32_t conversionUs() const { return _convUs; }
+
+  // Per-sample cost: I2C time of trigger + burst, and trigger -> values
+  const RunningStats &busStats() const { return _bus; }
+  const RunningStats &latencyStats() const { return _latency; }
+
+private:
+  TwoWire *_wire = nullptr;
+  uint8_t _addr = BME280_ADDR;
+  uint8_t _ctrlMeas = 0;  // osrs_t / osrs_p, mode bits clear
+  uint8_t _osP = BME280_OS_X1;
+  uint8_t _osH = BME280_OS_X1;
+  uint32_t _convUs = 0;
+  bool _pending = false;
+  uint32_t _triggeredAt = 0;
+  uint32_t _triggerBusUs = 0;
+  SemaphoreHandle_t _lock = nullptr;
+
+  RunningStats _bus;
+  RunningStats _latency;
+
+  struct {
+    uint16_t T1;
+    int16_t T2, T3;
+    uint16_t P1;
+    int16_t P2, P3, P4, P5, P6, P7, P8, P9;
+    uint8_t H1, H3;
+    int16_t H2, H4, H5;
+    int8_t H6;
+  } _cal;
+
+  bool readRegs(uint8_t reg, uint8_t *buf, uint8_t len);
+  bool writeReg(uint8_t reg, uint8_t value);
+  bool readCalibration();
+  bool triggerLocked();
+
+  int32_t compensateT(int32_t adcT, int32_t &tFine) const;
+  uint32_t compensateP(int32_t adcP, int32_t tFine) const;
+  uint32_t compensateH(int32_t adcH, int32_t tFine) const;
+};
@@ -0,0 +1,74 @@
+// boot_profiler.cpp
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+#include "boot_profiler.h"
+#include "config.h"
+
+extern AsyncWebServer server;
+
+static const char* const bootPhaseNames[BOOT_PHASE_COUNT] = {
+  "config", "web", "ota", "wifi", "sensors", "ntp", "mqtt", "first_sample"
+};
+
+struct BootPhaseTiming {
+  int64_t startUs;  // -1 = not started
+  int64_t endUs;    // -1 = not finished
+};
+
+static BootPhaseTiming phases[BOOT_PHASE_COUNT];
+static EventGroupHandle_t readyBits = nullptr;
+
+void bootProfilerInit() {
+  for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) phases[i] = { -1, -1 };
+  if (!readyBits) readyBits = xEventGroupCreate();
+}
+
+void bootPhaseBegin(BootPhase phase) {
+  if (phases[phase].startUs < 0) phases[phase].startUs = esp_timer_get_time();
+}
+
+void bootPhaseEnd(BootPhase phase) {
+  if (phases[phase].startUs < 0 || phases[phase].endUs >= 0) return;
+  phases[phase].endUs = esp_timer_get_time();
+  addLogf("[BOOT] %s done in %lu ms (t+%lu ms)", bootPhaseNames[phase],
+          (unsigned long)((phases[phase].endUs - phases[phase].startUs) / 1000),
+          (unsigned long)(phases[phase].endUs / 1000));
+}
+
+void bootSetReady(uint32_t bits) {
+  if (readyBits) xEventGroupSetBits(readyBits, bits);
+}
+
+bool bootIsReady(uint32_t bits) {
+  return readyBits && (xEventGroupGetBits(readyBits) & bits) == bits;
+}
+
+// {"type":"boot","phases":{"wifi":{"start":12,"ms":850},...},"ready":5}
+String bootProfileJson() {
+  StaticJsonDocument<768> doc;
+  doc["id"] = appConfig.deviceId;
+  doc["type"] = "boot";
+
+  JsonObject obj = doc.createNestedObject("phases");
+  for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+    if (phases[i].startUs < 0) continue;
+    JsonObject p = obj.createNestedObject(bootPhaseNames[i]);
+    p["start"] = (uint32_t)(phases[i].startUs / 1000);
+    if (phases[i].endUs >= 0) p["ms"] = (uint32_t)((phases[i].endUs - phases[i].startUs) / 1000);
+  }
+  doc["ready"] = readyBits ? (uint32_t)xEventGroupGetBits(readyBits) : 0;
+
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
+
+void setupBootRoutes() {
+  server.on("/api/boot", HTTP_GET, [](AsyncWebServerRequest *request) {
+    request->send(200, "application/json", bootProfileJson());
+  });
+}
@@ -0,0 +1,34 @@
+// boot_profiler.h
+#pragma once
+#include <Arduino.h>
+
+// Startup phases, timed from power-on (esp_timer)
+enum BootPhase : uint8_t {
+  BOOT_CONFIG,
+  BOOT_WEB,
+  BOOT_OTA,
+  BOOT_WIFI,      // async: ends on first got-IP
+  BOOT_SENSORS,   // sensor task: probe, init, warm-up
+  BOOT_NTP,       // async: ends on first SNTP sync
+  BOOT_MQTT,      // ends on first broker connection
+  BOOT_FIRST_SAMPLE,
+  BOOT_PHASE_COUNT
+};
+
+// Readiness gates. Dependency graph:
+//   SENSORS -> sampling / publishing
+//   WIFI    -> MQTT, NTP
+//   TIME is optional (timestamps are resolved later, see timebase.h)
+#define BOOT_READY_SENSORS (1 << 0)
+#define BOOT_READY_WIFI (1 << 1)
+#define BOOT_READY_TIME (1 << 2)
+#define BOOT_READY_MQTT (1 << 3)
+
+void bootProfilerInit();
+void bootPhaseBegin(BootPhase phase);
+void bootPhaseEnd(BootPhase phase);  // only the first end is recorded
+void bootSetReady(uint32_t bits);
+bool bootIsReady(uint32_t bits);
+
+String bootProfileJson();
+void setupBootRoutes();
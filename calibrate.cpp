@@ -10,8 +10,10 @@
 
 #include "data.h"
 #include "config.h"
+#include "config_schema.h"
 #include "ota_update.h"
 #include "calibrate.h"
+#include "stats.h"
 
 extern AsyncWebServer server;
 extern AsyncWebSocket ws;
@@ -20,28 +22,33 @@ bool calibratingMQ135 = false;
 bool calibratingDust = false;
 
 extern bool bmeInitialized;
-extern Adafruit_BME280 bme;
-extern GP2YDustSensor *dustSensor;
+extern Bme280 bme;
+extern DustEngine *dustSensor;
 extern MQ135 *mq135;
 
 unsigned long lastBaselineCalc = 0;
 
 #define BASELINE_CALC_INTERVAL 60000
-#define LAST_N_R0 8
 #define LAST_N_DUST 8
 
 extern AppConfig_t appConfig;
 
 // ---------------- Apply config to sensors ----------------
 void applyConfigToSensors() {
-    if (mq135 && isfinite(appConfig.mq_rzero)) {
-        mq135->setRZero(appConfig.mq_rzero);
-        addLogf("Applied MQ135 R0 = %.3f", appConfig.mq_rzero);
+    if (mq135) {
+        mq135->setRLoad(appConfig.mq_rl_kohm);
+        if (isfinite(appConfig.mq_rzero)) {
+            mq135->setRZero(appConfig.mq_rzero);
+            addLogf("Applied MQ135 R0 = %.3f", appConfig.mq_rzero);
+        }
     }
     if (dustSensor && isfinite(appConfig.dust_baseline)) {
         dustSensor->setBaseline(appConfig.dust_baseline);
         addLogf("Applied Dust Baseline = %.3f", appConfig.dust_baseline);
     }
+    if (dustSensor && isfinite(appConfig.dust_calibration) && appConfig.dust_calibration > 0.0f) {
+        dustSensor->setCalibrationFactor(appConfig.dust_calibration);
+    }
 }
 
 // ---------------- Auto drift correction ----------------
@@ -58,7 +65,7 @@ void updateBaselineDriftCorrection() {
 
         if (saveValue != oldBaseline) {
             appConfig.dust_baseline = saveValue;
-            saveConfig();
+            saveConfigDeferred();
             addLogf("Dust baseline drift updated: %.3f -> %.3f", oldBaseline, saveValue);
         }
     }
@@ -67,13 +74,38 @@ void updateBaselineDriftCorrection() {
 }
 
 // ---------------- MQ135 Calibration Task ----------------
+// Streams R0 reads through a MAD outlier gate into Welford statistics and
+// stops once the 95% confidence interval of the mean is within
+// appConfig.calTolerance, or after appConfig.calTimeout seconds.
+#define CAL_READ_INTERVAL_MS 100
+#define CAL_MIN_SAMPLES 10
+#define CAL_PROGRESS_MS 500
+
+static void sendCalibrationProgress(const char *state, const MadGatedStats<32> &est, float progress, uint32_t etaMs) {
+    StaticJsonDocument<256> doc;
+    doc["type"] = "calib";
+    doc["sensor"] = "mq135";
+    doc["state"] = state;
+    doc["n"] = est.stats.n;
+    doc["rejected"] = est.rejected;
+    doc["r0"] = safeRound(est.stats.average(), 3);
+    doc["ci"] = safeRound(est.ciHalfWidth(), 3);
+    doc["progress"] = (int)(progress * 100.0f);
+    doc["eta_ms"] = etaMs;
+
+    String json;
+    serializeJson(doc, json);
+    ws.textAll(json);
+}
+
 void mq135CalibrationTask(void *param) {
     bool *pCalib = (bool *)param;
     float temp = NAN, hum = NAN;
 
-    if (bmeInitialized) {
-        temp = bme.readTemperature();
-        hum = bme.readHumidity();
+    Bme280Reading env;
+    if (bmeInitialized && bme.read(env)) {
+        temp = env.temperature;
+        hum = env.humidity;
     }
 
     if (!isfinite(temp) || !isfinite(hum)) {
@@ -83,41 +115,63 @@ void mq135CalibrationTask(void *param) {
         return;
     }
 
-    addLogf("MQ135 calibration started (T=%.2f, H=%.2f)", temp, hum);
-
-    float r0Values[20];
-    int validCount = 0;
-
-    for (int i = 1; i <= 20; i++) {
-        float r0 = mq135->autoCalibrate(temp, hum);
-        if (isfinite(r0)) {
-            r0Values[validCount++] = r0;
-            addLogf("MQ135 sample %d: R0 = %.3f", i, r0);
-        } else {
-            addLogf("MQ135 sample %d: invalid", i);
+    float tol = appConfig.calTolerance;
+    addLogf("MQ135 calibration started (T=%.2f, H=%.2f, tolerance %.1f%%)", temp, hum, tol * 100.0f);
+
+    MadGatedStats<32> est;
+    unsigned long start = millis();
+    unsigned long lastProgress = 0;
+    unsigned long timeoutMs = appConfig.calTimeout * 1000UL;
+    bool converged = false;
+
+    while (millis() - start < timeoutMs) {
+        est.add(mq135->getCorrectedRZero(temp, hum));
+
+        float mean = est.stats.average();
+        float ci = est.ciHalfWidth();
+        float target = tol * mean;
+        converged = est.stats.n >= CAL_MIN_SAMPLES && ci <= target;
+        if (converged) break;
+
+        if (millis() - lastProgress >= CAL_PROGRESS_MS) {
+            // CI shrinks as 1/sqrt(n): samples needed = n * (ci / target)^2
+            float progress = 0.0f;
+            uint32_t etaMs = 0;
+            if (est.stats.n > 1 && isfinite(ci) && target > 0.0f) {
+                float needed = est.stats.n * (ci / target) * (ci / target);
+                if (needed < CAL_MIN_SAMPLES) needed = CAL_MIN_SAMPLES;
+                progress = min(1.0f, est.stats.n / needed);
+                float perSample = (millis() - start) / (float)(est.stats.n + est.rejected + MadGatedStats<32>::MIN_WINDOW);
+                etaMs = (uint32_t)((needed - est.stats.n) * perSample);
+            }
+            sendCalibrationProgress("running", est, progress, etaMs);
+            lastProgress = millis();
         }
-        vTaskDelay(500 / portTICK_PERIOD_MS);
+        vTaskDelay(CAL_READ_INTERVAL_MS / portTICK_PERIOD_MS);
     }
 
-    if (validCount == 0) {
-        addLog("MQ135 calibration failed: no valid R0");
+    float elapsed = (millis() - start) / 1000.0f;
+    if (!converged) {
+        sendCalibrationProgress("failed", est, 0.0f, 0);
+        addLogf("MQ135 calibration did not converge in %.0f s (R0 %.3f +/- %.3f, %u rejected), keeping %.3f",
+                elapsed, est.stats.average(), est.ciHalfWidth(), est.rejected, appConfig.mq_rzero);
         *pCalib = false;
         vTaskDelete(NULL);
         return;
     }
 
-    int N = min(LAST_N_R0, validCount);
-    float sum = 0;
-    for (int i = validCount - N; i < validCount; i++) sum += r0Values[i];
-
-    float avgR0 = sum / N;
+    float avgR0 = est.stats.average();
     float oldR0 = appConfig.mq_rzero;
 
-    appConfig.mq_rzero = avgR0;
-    saveConfig();
-    applyConfigToSensors();
+    // loop() persists it and applies it to the sensor (APPLY_CALIBRATION)
+    AppConfig_t next;
+    configPending(next);
+    next.mq_rzero = avgR0;
+    configSubmit(next, APPLY_CALIBRATION);
 
-    addLogf("MQ135 calibration result: %.3f (previous %.3f)", avgR0, oldR0);
+    sendCalibrationProgress("done", est, 1.0f, 0);
+    addLogf("MQ135 calibration result: %.3f +/- %.3f from %u samples in %.1f s, %u rejected (previous %.3f)",
+            avgR0, est.ciHalfWidth(), est.stats.n, elapsed, est.rejected, oldR0);
 
     *pCalib = false;
     vTaskDelete(NULL);
@@ -133,7 +187,6 @@ void startCalibration() {
     addLog("Starting calibration tasks...");
 
     calibratingMQ135 = true;
-    calibratingDust = true;
 
     xTaskCreate(mq135CalibrationTask, "MQ135CalTask", 4096, &calibratingMQ135, 1, NULL);
    // xTaskCreate(dustCalibrationTask, "DustCalTask", 4096, &calibratingDust, 1, NULL);
@@ -151,6 +204,7 @@ void setupCalibrationRoutes() {
 <body style='font-family:Arial;padding:20px;'>
 <h2>Calibrate MQ135 & Dust Sensor</h2>
 <button onclick="startCalibrate()" style='padding:10px;font-size:18px;'>Start Calibration</button>
+<div id='progress' style='margin-top:20px;font-size:16px;'></div>
 <pre id='log' style='background:#000;color:#0f0;padding:10px;margin-top:20px;height:200px;overflow:auto;white-space: pre-wrap;'></pre>
 <script>
 let ws = new WebSocket("ws://" + location.host + "/ws");
@@ -161,6 +215,11 @@ ws.onmessage = (event) => {
             let logEl = document.getElementById('log');
             logEl.innerHTML += msg.msg + "\n";
             logEl.scrollTop = logEl.scrollHeight;
+        } else if(msg.type === "calib"){
+            let eta = msg.state === "running" ? " - about " + Math.ceil(msg.eta_ms / 1000) + " s left" : "";
+            document.getElementById('progress').innerText =
+                "MQ135 " + msg.state + ": " + msg.progress + "%" + eta +
+                " (R0 " + msg.r0 + " +/- " + msg.ci + ", n=" + msg.n + ", rejected " + msg.rejected + ")";
         }
     } catch(e){}
 };
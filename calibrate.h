@@ -6,4 +6,5 @@
 
 void setupCalibrationRoutes();
 void startCalibration();
+void applyConfigToSensors();
 void updateBaselineDriftCorrection();
\ No newline at end of file
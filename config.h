@@ -6,6 +6,24 @@
 #define PREFERENCES_NAMESPACE "weather_cfg"
 #define DEVICE_ID_MAX_LEN 32
 
+// Log levels, picked from the message tag: [ERROR], [WARN], [DEBUG], rest INFO
+#define LOG_ERROR 0
+#define LOG_WARN 1
+#define LOG_INFO 2
+#define LOG_DEBUG 3
+
+// Derived metrics (derivedMask)
+#define DERIVE_DEW_POINT (1 << 0)
+#define DERIVE_HEAT_INDEX (1 << 1)
+#define DERIVE_ABS_HUMIDITY (1 << 2)
+#define DERIVE_SEA_LEVEL (1 << 3)
+
+// What the spike filter does with a flagged sample
+#define SPIKE_OFF 0
+#define SPIKE_FLAG 1     // publish as-is, mark in "spk"
+#define SPIKE_REPLACE 2  // publish the window median
+#define SPIKE_DROP 3     // leave the channel out
+
 // --- App Configuration ---
 typedef struct {
   // WiFi
@@ -25,6 +43,7 @@ typedef struct {
 
   // Timing
   uint32_t sendInterval;
+  uint32_t publishWindow;       // seconds per upstream summary, 0 = publish every sample
   char ntpServer[64];
 
   // GPIO
@@ -42,11 +61,46 @@ typedef struct {
 
   bool autoCalibrateOnBoot;
 
+  // Low-power duty cycle (deep sleep between wakes)
+  bool lowPowerMode;
+  uint16_t wakeInterval;    // seconds between wakes
+  uint16_t publishEveryN;   // radio up every N wakes
+  uint16_t sensorWarmupMs;  // settle time after sensor init
+
   // Device Info
   char deviceId[DEVICE_ID_MAX_LEN];
   float latitude;
   float longitude;
 
+  // Logging
+  uint8_t logLevel;         // LOG_ERROR .. LOG_DEBUG
+
+  // MQ135 calibration stop criteria
+  float calTolerance;       // 95% CI half-width of R0, relative
+  uint16_t calTimeout;      // seconds before giving up
+
+  // PM humidity correction (kappa-Koehler growth, 0 = off)
+  float pmKappa;
+
+  // Spike filter (SPIKE_*)
+  uint8_t spikePolicy;
+
+  // AQI scale (AqiStandard in aqi.h)
+  uint8_t aqiStandard;
+
+  // Derived metrics (DERIVE_*) and station altitude for sea-level pressure
+  uint8_t derivedMask;
+  float altitude;  // m
+
+  // BME280 forced-mode settings (BME280_OS_* / filter code 0..4)
+  uint8_t bmeOsT;
+  uint8_t bmeOsP;
+  uint8_t bmeOsH;
+  uint8_t bmeFilter;
+
+  // Per-subsystem heap attribution (heap_monitor.h)
+  bool heapTrack;
+
 } AppConfig_t;
 
 // --- Global Config Instance ---
@@ -54,8 +108,24 @@ extern AppConfig_t appConfig;
 
 // --- Config Management ---
 void loadConfig();
-void saveConfig();
-void resetConfig();
+void saveConfig();           // writes changed groups now
+void saveConfigDeferred();   // coalesced, for hot calibration values
+void configPersistLoop();
+void configPersistFlush();
+void resetConfig();          // defaults, saved and rebooted from loop()
+uint32_t configWritesSinceBoot();
+uint32_t configWritesLifetime();
+
+// --- Live apply ---
+// The web task only submits a validated copy; loop() assigns it, saves it
+// and runs the handlers subscribed to the APPLY_* bits in mask
+// (config_schema.h). APPLY_RESTART reboots after the save.
+typedef void (*ConfigApplyHandler)(uint8_t changed);
+void configSubscribe(uint8_t mask, ConfigApplyHandler handler);
+void configSubmit(const AppConfig_t& next, uint8_t mask);
+void configPending(AppConfig_t& out);  // last submitted copy, else appConfig
+void configRequestRestart();           // flush pending saves and reboot from loop()
+void configApplyLoop();
 
 // --- Logging ---
 struct LogEntry {
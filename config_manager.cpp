@@ -2,9 +2,12 @@
 #include <Preferences.h>
 #include <ArduinoJson.h>
 #include <cstdarg>
+#include <cstddef>
 
 #include "config.h"
 #include "data.h"
+#include "config_schema.h"
+#include "heap_monitor.h"
 
 // --- Global Instances ---
 AppConfig_t appConfig;
@@ -13,76 +16,375 @@ Preferences preferences;
 LogEntry logBuffer[LOG_BUFFER_SIZE];
 uint8_t logIndex = 0;
 
-// --- Default Config ---
-const AppConfig_t defaultConfig = {
-  .wifiSSID = "HH",
-  .wifiPass = "12345678",
+// =====================================================================
+// Persistence: one NVS key per field (see config_schema.cpp), written only
+// when changed. Hot calibration values go through saveConfigDeferred(),
+// which coalesces writes for CONFIG_COALESCE_MS.
+// =====================================================================
+#define CONFIG_COALESCE_MS (10UL * 60UL * 1000UL)
 
-  .mqttServer = "pi.hoan.uk",
-  .mqttPort = 1883,
-  .mqttUser = "sensor",
-  .mqttPass = "pass1234",
-  .mqttTopic = "weather/data",
-  .mqttEnabled = true,
+static AppConfig_t persistedConfig;  // what NVS currently holds
+static uint32_t bootWrites = 0;
+static uint32_t lifetimeWrites = 0;
+static bool deferredPending = false;
+static unsigned long deferredSince = 0;
 
-  .queueMaxSize = 200 * 1024,  // 200 KB default
-  .queueFlushInterval = 5000,  // try sending every 5s
+// Everything is logged until loadConfig() has run
+static uint8_t logThreshold = LOG_DEBUG;
 
-  .sendInterval = 5000,
-  .ntpServer = "pool.ntp.org",
+// --- Reset config to defaults ---
+void resetConfig() {
+  addLog("[CFG] Resetting to default configuration...");
+  AppConfig_t defaults;
+  configApplyDefaults(defaults);
+  configSubmit(defaults, APPLY_RESTART);
+}
+
+// --- Save changed fields to NVS ---
+void saveConfig() {
+  deferredPending = false;
 
-  .dustLEDPin = 15,
-  .dustADCPin = 35,
-  .mqADCPin = 34,
+  uint8_t count = 0;
 
-  .mq_rl_kohm = 1.0,
-  .mq_r0_ratio_clean = 3.6,
-  .mq_rzero = 0,
-  .dust_baseline = 0,
-  .dust_calibration = 1,
+  preferences.begin(PREFERENCES_NAMESPACE, false);
+  for (size_t i = 0; i < configSchemaSize; i++) {
+    const ConfigField& f = configSchema[i];
+    if (!configFieldDiffers(f, appConfig, persistedConfig)) continue;
 
-  .autoCalibrateOnBoot = true,
+    configFieldStore(preferences, f, appConfig);
+    count++;
+  }
 
+  if (count > 0) {
+    bootWrites += count;
+    lifetimeWrites += count;
+    preferences.putUInt("writes", lifetimeWrites);
+  }
+  preferences.end();
 
-  .deviceId = "01",
-  .latitude = 21.5,
-  .longitude = 105.8,
+  memcpy(&persistedConfig, &appConfig, sizeof(AppConfig_t));
+
+  if (count > 0) addLogf("[CFG] Saved %u changed field(s) to NVS", count);
+  else addLog("[CFG] No configuration changes to save");
+}
+
+// --- Coalesced save for frequently changing values ---
+void saveConfigDeferred() {
+  if (!deferredPending) {
+    deferredPending = true;
+    deferredSince = millis();
+  }
+}
+
+void configPersistLoop() {
+  if (deferredPending && millis() - deferredSince >= CONFIG_COALESCE_MS) saveConfig();
+}
+
+void configPersistFlush() {
+  if (deferredPending) saveConfig();
+}
+
+uint32_t configWritesSinceBoot() {
+  return bootWrites;
+}
+
+uint32_t configWritesLifetime() {
+  return lifetimeWrites;
+}
+
+// =====================================================================
+// Migration from older storage layouts. Old blobs are read into frozen
+// copies of the struct as it was laid out then, and copied over field by
+// field, so fields added since keep their defaults.
+// =====================================================================
+
+// Fields present in every layout. Strings are truncated if they shrank.
+template <size_t N, size_t M>
+static void copyLegacyStr(char (&dst)[N], const char (&src)[M]) {
+  size_t n = strnlen(src, M);
+  if (n >= N) n = N - 1;
+  memcpy(dst, src, n);
+  dst[n] = '\0';
+}
+
+template <typename D, typename S>
+static void copyBaselineFields(D& dst, const S& src) {
+  copyLegacyStr(dst.wifiSSID, src.wifiSSID);
+  copyLegacyStr(dst.wifiPass, src.wifiPass);
+  copyLegacyStr(dst.mqttServer, src.mqttServer);
+  dst.mqttPort = src.mqttPort;
+  copyLegacyStr(dst.mqttUser, src.mqttUser);
+  copyLegacyStr(dst.mqttPass, src.mqttPass);
+  copyLegacyStr(dst.mqttTopic, src.mqttTopic);
+  dst.mqttEnabled = src.mqttEnabled;
+  dst.queueMaxSize = src.queueMaxSize;
+  dst.queueFlushInterval = src.queueFlushInterval;
+  dst.sendInterval = src.sendInterval;
+  copyLegacyStr(dst.ntpServer, src.ntpServer);
+  dst.dustLEDPin = src.dustLEDPin;
+  dst.dustADCPin = src.dustADCPin;
+  dst.mqADCPin = src.mqADCPin;
+  dst.mq_rl_kohm = src.mq_rl_kohm;
+  dst.mq_r0_ratio_clean = src.mq_r0_ratio_clean;
+  dst.mq_rzero = src.mq_rzero;
+  dst.dust_baseline = src.dust_baseline;
+  dst.dust_calibration = src.dust_calibration;
+  dst.autoCalibrateOnBoot = src.autoCalibrateOnBoot;
+  copyLegacyStr(dst.deviceId, src.deviceId);
+  dst.latitude = src.latitude;
+  dst.longitude = src.longitude;
+}
+
+// v1 (original firmware): whole struct as one blob under "config". Frozen.
+struct AppConfigV1 {
+  char wifiSSID[32];
+  char wifiPass[64];
+  char mqttServer[64];
+  uint16_t mqttPort;
+  char mqttUser[32];
+  char mqttPass[64];
+  char mqttTopic[64];
+  bool mqttEnabled;
+  uint32_t queueMaxSize;
+  uint16_t queueFlushInterval;
+  uint32_t sendInterval;
+  char ntpServer[64];
+  uint8_t dustLEDPin;
+  uint8_t dustADCPin;
+  uint8_t mqADCPin;
+  float mq_rl_kohm;
+  float mq_r0_ratio_clean;
+  float mq_rzero;
+  float dust_baseline;
+  float dust_calibration;
+  bool autoCalibrateOnBoot;
+  char deviceId[32];
+  float latitude;
+  float longitude;
 };
 
-// --- Reset config to defaults ---
-void resetConfig() {
-  addLog("[CFG] Resetting to default configuration...");
-  memcpy(&appConfig, &defaultConfig, sizeof(AppConfig_t));
-  saveConfig();
+// v2: v1 plus publishWindow and the low-power fields, one blob per field
+// group at the offsets of this layout. Frozen.
+struct AppConfigV2 {
+  char wifiSSID[32];
+  char wifiPass[64];
+  char mqttServer[64];
+  uint16_t mqttPort;
+  char mqttUser[32];
+  char mqttPass[64];
+  char mqttTopic[64];
+  bool mqttEnabled;
+  uint32_t queueMaxSize;
+  uint16_t queueFlushInterval;
+  uint32_t sendInterval;
+  uint32_t publishWindow;
+  char ntpServer[64];
+  uint8_t dustLEDPin;
+  uint8_t dustADCPin;
+  uint8_t mqADCPin;
+  float mq_rl_kohm;
+  float mq_r0_ratio_clean;
+  float mq_rzero;
+  float dust_baseline;
+  float dust_calibration;
+  bool autoCalibrateOnBoot;
+  bool lowPowerMode;
+  uint16_t wakeInterval;
+  uint16_t publishEveryN;
+  uint16_t sensorWarmupMs;
+  char deviceId[32];
+  float latitude;
+  float longitude;
+};
+
+template <typename D, typename S>
+static void copyV2Fields(D& dst, const S& src) {
+  copyBaselineFields(dst, src);
+  dst.publishWindow = src.publishWindow;
+  dst.lowPowerMode = src.lowPowerMode;
+  dst.wakeInterval = src.wakeInterval;
+  dst.publishEveryN = src.publishEveryN;
+  dst.sensorWarmupMs = src.sensorWarmupMs;
 }
 
-// --- Save config to NVS ---
-void saveConfig() {
-  preferences.begin(PREFERENCES_NAMESPACE, false);
-  preferences.putBytes("config", &appConfig, sizeof(AppConfig_t));
-  preferences.end();
-  addLog("[CFG] Configuration saved to NVS");
+struct LegacyGroup {
+  const char* key;
+  size_t offset;
+  size_t size;
+};
+
+#define LEGACY_GROUP(key, first, next) \
+  { key, offsetof(AppConfigV2, first), offsetof(AppConfigV2, next) - offsetof(AppConfigV2, first) }
+
+static const LegacyGroup legacyGroupsV2[] = {
+  LEGACY_GROUP("wifi", wifiSSID, mqttServer),
+  LEGACY_GROUP("mqtt", mqttServer, queueMaxSize),
+  LEGACY_GROUP("queue", queueMaxSize, sendInterval),
+  LEGACY_GROUP("timing", sendInterval, dustLEDPin),
+  LEGACY_GROUP("gpio", dustLEDPin, mq_rl_kohm),
+  LEGACY_GROUP("calib", mq_rl_kohm, lowPowerMode),
+  LEGACY_GROUP("lowpower", lowPowerMode, deviceId),
+  { "device", offsetof(AppConfigV2, deviceId), sizeof(AppConfigV2) - offsetof(AppConfigV2, deviceId) },
+};
+
+static void migrateV2Groups() {
+  // Groups that are missing or mismatched keep the current defaults
+  AppConfigV2 old;
+  copyV2Fields(old, appConfig);
+
+  uint8_t loaded = 0;
+  for (const LegacyGroup& g : legacyGroupsV2) {
+    if (preferences.getBytesLength(g.key) == g.size) {
+      preferences.getBytes(g.key, (uint8_t*)&old + g.offset, g.size);
+      loaded++;
+    }
+    preferences.remove(g.key);
+  }
+  copyV2Fields(appConfig, old);
+  addLogf("[CFG] Migrated %u group(s) from v2 storage", loaded);
+}
+
+static void migrateV1Blob() {
+  size_t size = preferences.getBytesLength("config");
+  if (size == sizeof(AppConfigV1)) {
+    AppConfigV1 old;
+    preferences.getBytes("config", &old, sizeof(old));
+    copyBaselineFields(appConfig, old);
+    addLog("[CFG] Migrated single-blob v1 config");
+  } else {
+    addLogf("[CFG] Unknown v1 config blob (%u bytes), using defaults", (unsigned)size);
+  }
+  preferences.remove("config");
 }
 
 // --- Load config from NVS ---
 void loadConfig() {
-  preferences.begin(PREFERENCES_NAMESPACE, true);
+  configApplyDefaults(appConfig);
+  // Shadow starts from defaults: every field not read from NVS gets written
+  configApplyDefaults(persistedConfig);
 
-  size_t savedSize = preferences.getBytesLength("config");
+  preferences.begin(PREFERENCES_NAMESPACE, false);
+  uint8_t version = preferences.getUChar("ver", 0);
+  lifetimeWrites = preferences.getUInt("writes", 0);
 
-  if (savedSize == sizeof(AppConfig_t)) {
-    preferences.getBytes("config", &appConfig, sizeof(AppConfig_t));
-    addLog("[CFG] Config loaded from NVS");
+  bool migrated = false;
+  if (version == CONFIG_SCHEMA_VERSION) {
+    // Missing or mismatched fields (e.g. added by a firmware update) keep defaults
+    uint8_t loaded = 0;
+    for (size_t i = 0; i < configSchemaSize; i++) {
+      if (configFieldLoad(preferences, configSchema[i], appConfig)) loaded++;
+    }
+    addLogf("[CFG] Config loaded from NVS (%u/%u fields)", loaded, (unsigned)configSchemaSize);
+  } else if (version == 2) {
+    migrateV2Groups();
+    migrated = true;
+  } else if (preferences.isKey("config")) {
+    migrateV1Blob();
+    migrated = true;
   } else {
     addLog("[CFG] No valid config — using defaults");
-    memcpy(&appConfig, &defaultConfig, sizeof(AppConfig_t));
   }
 
+  if (version != CONFIG_SCHEMA_VERSION) preferences.putUChar("ver", CONFIG_SCHEMA_VERSION);
   preferences.end();
+
+  configValidate(appConfig);
+
+  // Fields loaded as-is need no rewrite; migrated ones are written per field
+  if (!migrated) {
+    preferences.begin(PREFERENCES_NAMESPACE, true);
+    for (size_t i = 0; i < configSchemaSize; i++) configFieldLoad(preferences, configSchema[i], persistedConfig);
+    preferences.end();
+  }
+  if (migrated || version != CONFIG_SCHEMA_VERSION) saveConfig();
+  logThreshold = appConfig.logLevel;
+}
+
+// =====================================================================
+// Live apply: /save and the calibration task hand over the new config
+// and the APPLY_* classes it changes; loop() assigns, persists and
+// dispatches it, so appConfig and NVS are only written from loop()
+// =====================================================================
+#define CONFIG_MAX_SUBSCRIBERS 8
+
+struct ConfigSubscriber {
+  uint8_t mask;
+  ConfigApplyHandler handler;
+};
+
+static ConfigSubscriber subscribers[CONFIG_MAX_SUBSCRIBERS];
+static uint8_t subscriberCount = 0;
+static portMUX_TYPE pendingMux = portMUX_INITIALIZER_UNLOCKED;
+static AppConfig_t pendingConfig;
+static bool pendingValid = false;
+static uint8_t pendingMask = 0;
+
+void configSubscribe(uint8_t mask, ConfigApplyHandler handler) {
+  if (subscriberCount >= CONFIG_MAX_SUBSCRIBERS) {
+    addLog("[ERROR] Too many config subscribers");
+    return;
+  }
+  subscribers[subscriberCount++] = { mask, handler };
+}
+
+void configSubmit(const AppConfig_t& next, uint8_t mask) {
+  portENTER_CRITICAL(&pendingMux);
+  pendingConfig = next;
+  pendingValid = true;
+  pendingMask |= mask;
+  portEXIT_CRITICAL(&pendingMux);
+}
+
+// A second /save before loop() picked up the first builds on it
+void configPending(AppConfig_t& out) {
+  portENTER_CRITICAL(&pendingMux);
+  out = pendingValid ? pendingConfig : appConfig;
+  portEXIT_CRITICAL(&pendingMux);
+}
+
+void configRequestRestart() {
+  AppConfig_t cfg;
+  configPending(cfg);
+  configSubmit(cfg, APPLY_RESTART);
+}
+
+void configApplyLoop() {
+  portENTER_CRITICAL(&pendingMux);
+  bool submitted = pendingValid;
+  if (submitted) appConfig = pendingConfig;
+  pendingValid = false;
+  uint8_t mask = pendingMask;
+  pendingMask = 0;
+  portEXIT_CRITICAL(&pendingMux);
+  if (!submitted) return;
+
+  saveConfig();  // also flushes a deferred save
+  if (mask & APPLY_RESTART) {
+    addLog("Configuration updated. Rebooting...");
+    delay(1000);  // let the HTTP response go out
+    ESP.restart();
+  }
+  if (!mask) return;
+
+  if (mask & APPLY_LOG) logThreshold = appConfig.logLevel;
+  for (uint8_t i = 0; i < subscriberCount; i++) {
+    if (subscribers[i].mask & mask) subscribers[i].handler(mask);
+  }
+  addLogf("[CFG] Applied live changes (mask 0x%02X)", mask);
 }
 
 // --- Logging ---
+static uint8_t logLevelOf(const char* msg) {
+  if (strncmp(msg, "[ERROR]", 7) == 0) return LOG_ERROR;
+  if (strncmp(msg, "[WARN]", 6) == 0) return LOG_WARN;
+  if (strncmp(msg, "[DEBUG]", 7) == 0) return LOG_DEBUG;
+  return LOG_INFO;
+}
+
 void addLog(const char* msg) {
+  if (logLevelOf(msg) > logThreshold) return;
+  HEAP_SCOPE(HEAP_LOG);
+
   Serial.println(msg);
 
   logBuffer[logIndex].message = msg;
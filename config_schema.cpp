@@ -0,0 +1,297 @@
+// config_schema.cpp
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Preferences.h>
+#include <cstring>
+
+#include "config_schema.h"
+
+// =====================================================================
+// Field table
+// =====================================================================
+constexpr ConfigField configSchema[] = {
+  // WiFi
+  CFG_STRING(wifiSSID, "ssid", "HH", APPLY_WIFI),
+  CFG_STRING(wifiPass, "wpass", "12345678", APPLY_WIFI),
+
+  // MQTT
+  CFG_STRING(mqttServer, "mq_srv", "pi.hoan.uk", APPLY_MQTT),
+  CFG_NUM(mqttPort, "mq_port", 1, 65535, 1883, APPLY_MQTT),
+  CFG_STRING(mqttUser, "mq_user", "sensor", APPLY_MQTT),
+  CFG_STRING(mqttPass, "mq_pass", "pass1234", APPLY_MQTT),
+  CFG_STRING(mqttTopic, "mq_topic", "weather/data", APPLY_MQTT),
+  CFG_NUM(mqttEnabled, "mq_en", 0, 1, 1, APPLY_MQTT),
+
+  CFG_NUM(queueMaxSize, "q_max", 1024, 1048576, 200 * 1024, APPLY_LIVE),  // 200 KB default
+  CFG_NUM(queueFlushInterval, "q_flush", 500, 65535, 5000, APPLY_LIVE),   // try sending every 5s
+
+  // Timing
+  CFG_NUM(sendInterval, "send_iv", 100, 3600000, 5000, APPLY_SAMPLING),
+  CFG_NUM(publishWindow, "pub_win", 0, 86400, 0, APPLY_SAMPLING),
+  CFG_STRING(ntpServer, "ntp", "pool.ntp.org", APPLY_TIME),
+
+  // GPIO
+  CFG_NUM(dustLEDPin, "dust_led", 0, 39, 15, APPLY_RESTART),
+  CFG_NUM(dustADCPin, "dust_adc", 0, 39, 35, APPLY_RESTART),
+  CFG_NUM(mqADCPin, "mq_adc", 0, 39, 34, APPLY_RESTART),
+
+  // MQ135 Calibration
+  CFG_NUM(mq_rl_kohm, "mq_rl", 0.1, 1000, 1.0, APPLY_CALIBRATION),
+  CFG_NUM(mq_r0_ratio_clean, "mq_r0ratio", 0.1, 100, 3.6, APPLY_CALIBRATION),
+  CFG_NUM(mq_rzero, "mq_rzero", 0, 10000, 0, APPLY_CALIBRATION),
+  CFG_NUM(dust_baseline, "dust_base", 0, 1000, 0, APPLY_CALIBRATION),
+  CFG_NUM(dust_calibration, "dust_cal", 0.01, 100, 1, APPLY_CALIBRATION),
+
+  CFG_NUM(autoCalibrateOnBoot, "autocal", 0, 1, 1, APPLY_LIVE),
+
+  // Low-power duty cycle
+  CFG_NUM(lowPowerMode, "lp_mode", 0, 1, 0, APPLY_LIVE),
+  CFG_NUM(wakeInterval, "lp_wake", 5, 65535, 60, APPLY_LIVE),
+  CFG_NUM(publishEveryN, "lp_pubn", 1, 1000, 10, APPLY_LIVE),
+  CFG_NUM(sensorWarmupMs, "lp_warm", 0, 60000, 200, APPLY_LIVE),
+
+  // Device Info
+  CFG_STRING(deviceId, "dev_id", "01", APPLY_RESTART),
+  CFG_NUM(latitude, "lat", -90, 90, 21.5, APPLY_LIVE),
+  CFG_NUM(longitude, "lon", -180, 180, 105.8, APPLY_LIVE),
+
+  // Logging
+  CFG_NUM(logLevel, "log_lvl", LOG_ERROR, LOG_DEBUG, LOG_INFO, APPLY_LOG),
+
+  // Calibration
+  CFG_NUM(calTolerance, "cal_tol", 0.001, 0.5, 0.01, APPLY_LIVE),
+  CFG_NUM(calTimeout, "cal_tmo", 5, 600, 120, APPLY_LIVE),
+
+  // PM fusion
+  CFG_NUM(pmKappa, "pm_kappa", 0, 1, 0.4, APPLY_LIVE),
+  CFG_NUM(bmeOsT, "bme_os_t", 1, 5, 1, APPLY_SENSOR),
+  CFG_NUM(bmeOsP, "bme_os_p", 0, 5, 1, APPLY_SENSOR),
+  CFG_NUM(bmeOsH, "bme_os_h", 0, 5, 1, APPLY_SENSOR),
+  CFG_NUM(bmeFilter, "bme_filter", 0, 4, 0, APPLY_SENSOR),
+  CFG_NUM(aqiStandard, "aqi_std", 0, 2, 0, APPLY_LIVE),
+  CFG_NUM(derivedMask, "derived", 0, 15, DERIVE_DEW_POINT | DERIVE_HEAT_INDEX | DERIVE_ABS_HUMIDITY, APPLY_LIVE),
+  CFG_NUM(altitude, "altitude", -500, 9000, 0, APPLY_LIVE),
+  CFG_NUM(spikePolicy, "spike_pol", SPIKE_OFF, SPIKE_DROP, SPIKE_REPLACE, APPLY_LIVE),
+  CFG_NUM(heapTrack, "heap_track", 0, 1, 0, APPLY_LIVE),
+};
+
+constexpr size_t kSchemaSize = sizeof(configSchema) / sizeof(configSchema[0]);
+const size_t configSchemaSize = kSchemaSize;
+
+// --- Compile-time checks on the table ---
+static constexpr size_t cstrLen(const char *s) {
+  return *s ? 1 + cstrLen(s + 1) : 0;
+}
+
+static constexpr bool cstrEq(const char *a, const char *b) {
+  return *a == *b && (*a == '\0' || cstrEq(a + 1, b + 1));
+}
+
+static constexpr bool nvsKeysFit(size_t i) {
+  return i >= kSchemaSize || (cstrLen(configSchema[i].nvsKey) <= 15 && nvsKeysFit(i + 1));
+}
+
+static constexpr bool keyUniqueFrom(size_t i, size_t j) {
+  return j >= kSchemaSize || (!cstrEq(configSchema[i].nvsKey, configSchema[j].nvsKey) && keyUniqueFrom(i, j + 1));
+}
+
+static constexpr bool nvsKeysUnique(size_t i) {
+  return i >= kSchemaSize || (keyUniqueFrom(i, i + 1) && nvsKeysUnique(i + 1));
+}
+
+static constexpr bool defaultsValid(size_t i) {
+  return i >= kSchemaSize ||
+         ((configSchema[i].type == CFG_STR
+             ? cstrLen(configSchema[i].defStr) < configSchema[i].size
+             : configSchema[i].def >= configSchema[i].min && configSchema[i].def <= configSchema[i].max) &&
+          defaultsValid(i + 1));
+}
+
+static_assert(nvsKeysFit(0), "config NVS key longer than 15 characters");
+static_assert(nvsKeysUnique(0), "duplicate config NVS key");
+static_assert(defaultsValid(0), "config default out of bounds");
+
+// =====================================================================
+// Typed access
+// =====================================================================
+template <typename T>
+static double loadAs(const uint8_t *p) {
+  T v;
+  memcpy(&v, p, sizeof(T));
+  return (double)v;
+}
+
+template <typename T>
+static void storeAs(uint8_t *p, double v) {
+  T t = (T)v;
+  memcpy(p, &t, sizeof(T));
+}
+
+static const uint8_t *fieldPtr(const ConfigField &f, const AppConfig_t &cfg) {
+  return (const uint8_t *)&cfg + f.offset;
+}
+
+static uint8_t *fieldPtr(const ConfigField &f, AppConfig_t &cfg) {
+  return (uint8_t *)&cfg + f.offset;
+}
+
+static double readNum(const ConfigField &f, const AppConfig_t &cfg) {
+  const uint8_t *p = fieldPtr(f, cfg);
+  switch (f.type) {
+    case CFG_BOOL: return loadAs<bool>(p);
+    case CFG_U8: return loadAs<uint8_t>(p);
+    case CFG_U16: return loadAs<uint16_t>(p);
+    case CFG_U32: return loadAs<uint32_t>(p);
+    case CFG_F32: return loadAs<float>(p);
+    default: return NAN;
+  }
+}
+
+static void writeNum(const ConfigField &f, AppConfig_t &cfg, double v) {
+  uint8_t *p = fieldPtr(f, cfg);
+  switch (f.type) {
+    case CFG_BOOL: storeAs<bool>(p, v != 0); break;
+    case CFG_U8: storeAs<uint8_t>(p, v); break;
+    case CFG_U16: storeAs<uint16_t>(p, v); break;
+    case CFG_U32: storeAs<uint32_t>(p, v); break;
+    case CFG_F32: storeAs<float>(p, v); break;
+    default: break;
+  }
+}
+
+static bool numInBounds(const ConfigField &f, double v) {
+  return isfinite(v) && v >= f.min && v <= f.max;
+}
+
+const ConfigField *configFindField(const char *name) {
+  for (size_t i = 0; i < kSchemaSize; i++) {
+    if (strcmp(configSchema[i].name, name) == 0) return &configSchema[i];
+  }
+  return nullptr;
+}
+
+// =====================================================================
+// Defaults / validation
+// =====================================================================
+static void applyDefault(const ConfigField &f, AppConfig_t &cfg) {
+  if (f.type == CFG_STR) {
+    char *p = (char *)fieldPtr(f, cfg);
+    memset(p, 0, f.size);
+    strncpy(p, f.defStr, f.size - 1);
+  } else {
+    writeNum(f, cfg, f.def);
+  }
+}
+
+void configApplyDefaults(AppConfig_t &cfg) {
+  memset(&cfg, 0, sizeof(AppConfig_t));
+  for (size_t i = 0; i < kSchemaSize; i++) applyDefault(configSchema[i], cfg);
+}
+
+uint8_t configValidate(AppConfig_t &cfg) {
+  uint8_t fixed = 0;
+  for (size_t i = 0; i < kSchemaSize; i++) {
+    const ConfigField &f = configSchema[i];
+    bool ok = f.type == CFG_STR ? memchr(fieldPtr(f, cfg), '\0', f.size) != nullptr
+                                : numInBounds(f, readNum(f, cfg));
+    if (!ok) {
+      addLogf("[CFG] %s invalid, reverting to default", f.name);
+      applyDefault(f, cfg);
+      fixed++;
+    }
+  }
+  return fixed;
+}
+
+// =====================================================================
+// JSON
+// =====================================================================
+void configToJson(const AppConfig_t &cfg, JsonObject obj) {
+  for (size_t i = 0; i < kSchemaSize; i++) {
+    const ConfigField &f = configSchema[i];
+    switch (f.type) {
+      case CFG_STR: obj[f.name] = (const char *)fieldPtr(f, cfg); break;
+      case CFG_BOOL: obj[f.name] = readNum(f, cfg) != 0; break;
+      case CFG_F32: obj[f.name] = (float)readNum(f, cfg); break;
+      default: obj[f.name] = (uint32_t)readNum(f, cfg); break;
+    }
+  }
+}
+
+bool configFromJson(AppConfig_t &cfg, JsonObjectConst obj, char *err, size_t errLen) {
+  AppConfig_t next = cfg;
+
+  for (size_t i = 0; i < kSchemaSize; i++) {
+    const ConfigField &f = configSchema[i];
+    JsonVariantConst v = obj[f.name];
+    if (v.isNull()) continue;
+
+    bool ok;
+    if (f.type == CFG_STR) {
+      const char *s = v.as<const char *>();
+      ok = s && strlen(s) < f.size;
+      if (ok) {
+        char *p = (char *)fieldPtr(f, next);
+        memset(p, 0, f.size);
+        memcpy(p, s, strlen(s));
+      }
+    } else if (f.type == CFG_BOOL) {
+      ok = v.is<bool>();
+      if (ok) writeNum(f, next, v.as<bool>() ? 1 : 0);
+    } else {
+      double d = v.as<double>();
+      ok = v.is<double>() && numInBounds(f, d);
+      if (ok) writeNum(f, next, d);
+    }
+
+    if (!ok) {
+      snprintf(err, errLen, "%s", f.name);
+      return false;
+    }
+  }
+
+  cfg = next;
+  return true;
+}
+
+// =====================================================================
+// NVS: strings via putString (survive size changes), numbers as raw
+// bytes (a type change makes the stored value fall back to default)
+// =====================================================================
+bool configFieldLoad(Preferences &prefs, const ConfigField &f, AppConfig_t &cfg) {
+  if (!prefs.isKey(f.nvsKey)) return false;
+
+  if (f.type == CFG_STR) {
+    char buf[128];
+    size_t len = prefs.getString(f.nvsKey, buf, sizeof(buf));
+    if (len == 0 || strlen(buf) >= f.size) return false;
+    char *p = (char *)fieldPtr(f, cfg);
+    memset(p, 0, f.size);
+    memcpy(p, buf, strlen(buf));
+    return true;
+  }
+
+  if (prefs.getBytesLength(f.nvsKey) != f.size) return false;
+  return prefs.getBytes(f.nvsKey, fieldPtr(f, cfg), f.size) == f.size;
+}
+
+void configFieldStore(Preferences &prefs, const ConfigField &f, const AppConfig_t &cfg) {
+  if (f.type == CFG_STR) prefs.putString(f.nvsKey, (const char *)fieldPtr(f, cfg));
+  else prefs.putBytes(f.nvsKey, fieldPtr(f, cfg), f.size);
+}
+
+bool configFieldDiffers(const ConfigField &f, const AppConfig_t &a, const AppConfig_t &b) {
+  if (f.type == CFG_STR) return strncmp((const char *)fieldPtr(f, a), (const char *)fieldPtr(f, b), f.size) != 0;
+  return memcmp(fieldPtr(f, a), fieldPtr(f, b), f.size) != 0;
+}
+
+uint8_t configDiff(const AppConfig_t &a, const AppConfig_t &b, JsonArray *changed) {
+  uint8_t mask = 0;
+  for (size_t i = 0; i < kSchemaSize; i++) {
+    const ConfigField &f = configSchema[i];
+    if (!configFieldDiffers(f, a, b)) continue;
+    mask |= f.apply;
+    if (changed) changed->add(f.name);
+  }
+  return mask;
+}
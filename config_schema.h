@@ -0,0 +1,84 @@
+// config_schema.h
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Preferences.h>
+#include <stddef.h>
+
+#include "config.h"
+
+// =====================================================================
+// Reflected AppConfig_t schema.
+// One constexpr row per field (config_schema.cpp) drives defaults,
+// JSON encode/decode, validation and NVS persistence.
+// =====================================================================
+
+enum ConfigFieldType : uint8_t { CFG_STR, CFG_BOOL, CFG_U8, CFG_U16, CFG_U32, CFG_F32 };
+
+// Compile-time member type -> ConfigFieldType
+template <typename T> struct CfgTypeOf;
+template <size_t N> struct CfgTypeOf<char[N]> { static constexpr ConfigFieldType value = CFG_STR; };
+template <> struct CfgTypeOf<bool> { static constexpr ConfigFieldType value = CFG_BOOL; };
+template <> struct CfgTypeOf<uint8_t> { static constexpr ConfigFieldType value = CFG_U8; };
+template <> struct CfgTypeOf<uint16_t> { static constexpr ConfigFieldType value = CFG_U16; };
+template <> struct CfgTypeOf<uint32_t> { static constexpr ConfigFieldType value = CFG_U32; };
+template <> struct CfgTypeOf<float> { static constexpr ConfigFieldType value = CFG_F32; };
+
+// How a change to a field takes effect; see configSubscribe() in config.h
+#define APPLY_LIVE 0               // read on use, nothing to do
+#define APPLY_SAMPLING (1 << 0)
+#define APPLY_MQTT (1 << 1)
+#define APPLY_CALIBRATION (1 << 2)
+#define APPLY_LOG (1 << 3)
+#define APPLY_TIME (1 << 4)
+#define APPLY_WIFI (1 << 5)
+#define APPLY_SENSOR (1 << 6)      // BME280 sampling settings
+#define APPLY_RESTART (1 << 7)     // pins, hostname: needs a reboot
+
+struct ConfigField {
+  const char *name;    // JSON key (member name)
+  const char *nvsKey;  // NVS key, max 15 chars
+  uint16_t offset;
+  uint16_t size;
+  ConfigFieldType type;
+  double min;          // numeric bounds, inclusive
+  double max;
+  double def;          // numeric default
+  const char *defStr;  // string default
+  uint8_t apply;       // APPLY_* class
+};
+
+#define CFG_MEMBER_TYPE(member) CfgTypeOf<decltype(AppConfig_t::member)>::value
+
+#define CFG_NUM(member, nvs, lo, hi, def, apply) \
+  { #member, nvs, offsetof(AppConfig_t, member), sizeof(AppConfig_t::member), CFG_MEMBER_TYPE(member), lo, hi, def, nullptr, apply }
+
+#define CFG_STRING(member, nvs, def, apply) \
+  { #member, nvs, offsetof(AppConfig_t, member), sizeof(AppConfig_t::member), CFG_STR, 0, 0, 0, def, apply }
+
+#define CONFIG_SCHEMA_VERSION 3
+
+extern const ConfigField configSchema[];
+extern const size_t configSchemaSize;
+
+const ConfigField *configFindField(const char *name);
+
+void configApplyDefaults(AppConfig_t &cfg);
+void configToJson(const AppConfig_t &cfg, JsonObject obj);
+
+// Decodes every known key present in obj into cfg. Returns false (and
+// leaves cfg untouched) if any value fails validation; the first
+// offending field name is written to err.
+bool configFromJson(AppConfig_t &cfg, JsonObjectConst obj, char *err, size_t errLen);
+
+// APPLY_* mask of fields that differ between a and b; changed field names
+// are appended to changed (if not null)
+uint8_t configDiff(const AppConfig_t &a, const AppConfig_t &b, JsonArray *changed);
+
+// Sanity pass after loading: invalid fields revert to their defaults
+uint8_t configValidate(AppConfig_t &cfg);
+
+// Per-field NVS storage
+bool configFieldLoad(Preferences &prefs, const ConfigField &f, AppConfig_t &cfg);
+void configFieldStore(Preferences &prefs, const ConfigField &f, const AppConfig_t &cfg);
+bool configFieldDiffers(const ConfigField &f, const AppConfig_t &a, const AppConfig_t &b);
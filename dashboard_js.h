@@ -4,7 +4,7 @@
 const char dashboard_js[] PROGMEM = R"rawliteral(
 
 
-let tempData=[], humData=[], presData=[], dustData=[], aqiData=[], mqData=[];
+const tiles = {};  // channel key -> { data, gauge, chart }, built by loadSensors()
 const maxPoints = 120;
 const TIME_RANGE_STORAGE_KEY = 'chartTimeRange';
 
@@ -176,23 +176,49 @@ const zonesPres = [{max: 720, color: '#f39c12'}, {max: 1050, color: '#2ecc71'},
 const zonesDust = [{max: 12, color: '#2ecc71'}, {max: 35, color: '#f39c12'}, {max: 55, color: '#e67e22'}, {max: 150, color: '#e74c3c'}, {max: 320, color: '#9b59b6'}]; 
 const zonesAQI = [{max: 50, color: '#2ecc71'}, {max: 100, color: '#f39c12'}, {max: 150, color: '#e67e22'}, {max: 200, color: '#e74c3c'}, {max: 320, color: '#9b59b6'}]; 
 const zonesMQ = [{max: 200, color: '#2ecc71'}, {max: 500, color: '#f39c12'}, {max: 1000, color: '#e74c3c'}];
-
-// --- Init Gauges ---
-const chartTempGauge = createSolidGauge('gaugeTemp', 'Temperature', '', 0, 50, zonesTemp, 1);
-const chartHumGauge = createSolidGauge('gaugeHum', 'Humidity', '', 0, 100, zonesHum, 0);
-const chartPresGauge = createSolidGauge('gaugePres', 'Pressure', '', 800, 1100, zonesPres, 0);
-const chartDustGauge = createSolidGauge('gaugeDust', 'PM2.5', '', 0, 250, zonesDust, 0, true);
-const chartAQIGauge = createSolidGauge('gaugeAQI', 'AQI', '', 0, 300, zonesAQI, 0, true);
-const chartMQGauge = createSolidGauge('gaugeMQ', 'MQ Index', '', 0, 1000, zonesMQ, 0, true);
-
-// --- Init Line Charts ---
-const chartTemp = createLineChart('chartTemp', 'Temperature', '', '#e74c3c');
-const chartHum = createLineChart('chartHum', 'Humidity', '', '#3498db');
-const chartPres = createLineChart('chartPres', 'Pressure', '', '#34495e');
-const chartDust = createLineChart('chartDust', 'PM2.5', '', '#e67e22');
-const chartAQI = createLineChart('chartAQI', 'AQI', '', '#9b59b6');
-const chartMQ = createLineChart('chartMQ', 'MQ Index', '', '#f39c12');
-
+const zonesDew = [{max: 10, color: '#3498db'}, {max: 18, color: '#2ecc71'}, {max: 40, color: '#e74c3c'}];
+const zonesAH = [{max: 5, color: '#f39c12'}, {max: 15, color: '#2ecc71'}, {max: 30, color: '#3498db'}];
+const zonesSD = [{max: 5, color: '#2ecc71'}, {max: 15, color: '#f39c12'}, {max: 50, color: '#e74c3c'}];
+
+// Gauge range and colours per channel key; unknown keys get tileDefault
+const tileStyles = {
+    t:     { min: 0,   max: 50,   zones: zonesTemp, color: '#e74c3c' },
+    h:     { min: 0,   max: 100,  zones: zonesHum,  color: '#3498db' },
+    p:     { min: 800, max: 1100, zones: zonesPres, color: '#34495e' },
+    pm:    { min: 0,   max: 250,  zones: zonesDust, color: '#e67e22' },
+    aqi:   { min: 0,   max: 300,  zones: zonesAQI,  color: '#9b59b6' },
+    mq:    { min: 0,   max: 1000, zones: zonesMQ,   color: '#f39c12' },
+    pm_sd: { min: 0,   max: 50,   zones: zonesSD,   color: '#7f8c8d' },
+    dp:    { min: -10, max: 40,   zones: zonesDew,  color: '#16a085' },
+    hi:    { min: 0,   max: 60,   zones: zonesTemp, color: '#c0392b' },
+    ah:    { min: 0,   max: 30,   zones: zonesAH,   color: '#2980b9' },
+    slp:   { min: 800, max: 1100, zones: zonesPres, color: '#2c3e50' }
+};
+const tileDefault = { min: 0, max: 100, zones: [{max: 100, color: '#3498db'}], color: '#3498db' };
+
+function addTile(grid, f) {
+    const style = tileStyles[f.key] || tileDefault;
+    const tile = document.createElement('div');
+    tile.className = 'data-tile';
+    tile.dataset.key = f.key;
+    const header = document.createElement('h4');
+    header.className = 'tile-header';
+    header.innerText = f.unit ? f.label + ' (' + f.unit + ')' : f.label;
+    const gauge = document.createElement('div');
+    gauge.id = 'gauge_' + f.key;
+    gauge.className = 'gauge-container';
+    const chart = document.createElement('div');
+    chart.id = 'chart_' + f.key;
+    chart.className = 'chart-container';
+    tile.append(header, gauge, chart);
+    grid.appendChild(tile);
+
+    tiles[f.key] = {
+        data: [],
+        gauge: createSolidGauge(gauge.id, f.label, '', style.min, style.max, style.zones, f.decimals),
+        chart: createLineChart(chart.id, f.label, '', style.color)
+    };
+}
 
 // --- Helper function to update the Solid Gauge ---
 function updateGauge(gaugeChart, value, redraw = true) {
@@ -226,12 +252,7 @@ function updateCharts(){
     };
 
     // IMPORTANT: All must be 'true' to redraw individual charts
-    setChartData(chartTemp, getFilteredData(tempData), true);
-    setChartData(chartHum, getFilteredData(humData), true);
-    setChartData(chartPres, getFilteredData(presData), true);
-    setChartData(chartDust, getFilteredData(dustData), true);
-    setChartData(chartAQI, getFilteredData(aqiData), true);
-    setChartData(chartMQ, getFilteredData(mqData), true); 
+    Object.values(tiles).forEach(tile => setChartData(tile.chart, getFilteredData(tile.data), true));
 }
 
 // --- LocalStorage Logic (No change) ---
@@ -292,37 +313,12 @@ function connectWS(){
 
     let isNewData = false;
 
-    // --- Sensor data ---
-    if (d.type !== "log" && (d.t !== undefined || d.h !== undefined)) {
-
-        if (d.t !== undefined) {
-            addData(tempData, ts, d.t);
-            updateGauge(chartTempGauge, d.t);
-            isNewData = true;
-        }
-        if (d.h !== undefined) {
-            addData(humData, ts, d.h);
-            updateGauge(chartHumGauge, d.h);
-            isNewData = true;
-        }
-        if (d.p !== undefined) {
-            addData(presData, ts, d.p);
-            updateGauge(chartPresGauge, d.p);
-            isNewData = true;
-        }
-        if (d.pm !== undefined) {
-            addData(dustData, ts, d.pm);
-            updateGauge(chartDustGauge, d.pm);
-            isNewData = true;
-        }
-        if (d.aqi !== undefined) {
-            addData(aqiData, ts, d.aqi);
-            updateGauge(chartAQIGauge, d.aqi);
-            isNewData = true;
-        }
-        if (d.mq !== undefined) {
-            addData(mqData, ts, d.mq);
-            updateGauge(chartMQGauge, d.mq);
+    // --- Sensor data: every channel that has a tile ---
+    if (d.type !== "log") {
+        for (const key in tiles) {
+            if (typeof d[key] !== "number") continue;
+            addData(tiles[key].data, ts, d[key]);
+            updateGauge(tiles[key].gauge, d[key]);
             isNewData = true;
         }
     }
@@ -381,6 +377,17 @@ function connectWS(){
     ws.onerror = e => ws.close();
 }
 
+// --- Sensor metadata: one tile per channel this build reports ---
+function loadSensors() {
+    fetch('/api/sensors').then(r => r.json()).then(meta => {
+        const grid = document.getElementById('dataGrid');
+        meta.sensors.forEach(s => s.fields.forEach(f => {
+            if (!tiles[f.key]) addTile(grid, f);
+        }));
+        updateCharts();
+    }).catch(() => setTimeout(loadSensors, 2000));
+}
+
 // --- Init (No change) ---
 document.addEventListener('DOMContentLoaded', () => {
     const btn = document.getElementById('logToggleBtn');
@@ -393,6 +400,7 @@ document.addEventListener('DOMContentLoaded', () => {
     }
 
     loadTimeRange(); 
+    loadSensors();
     connectWS();
 
     const sel = document.getElementById('timeRangeSelect');
@@ -262,45 +262,8 @@ Here, we keep it simple: separated by background and line.
     </div>
 </div>
 
-<section class="data-grid">
-
-<div class="data-tile">
-  <h4 class="tile-header">Temperature (°C)</h4>
-  <div id="gaugeTemp" class="gauge-container"></div>
-  <div id="chartTemp" class="chart-container"></div>
-</div>
-
-<div class="data-tile">
-  <h4 class="tile-header">Humidity (%)</h4>
-  <div id="gaugeHum" class="gauge-container"></div>
-  <div id="chartHum" class="chart-container"></div>
-</div>
-
-<div class="data-tile">
-  <h4 class="tile-header">Pressure (hPa)</h4>
-  <div id="gaugePres" class="gauge-container"></div>
-  <div id="chartPres" class="chart-container"></div>
-</div>
-
-<div class="data-tile">
-  <h4 class="tile-header">PM2.5 (µg/m³)</h4>
-  <div id="gaugeDust" class="gauge-container"></div>
-  <div id="chartDust" class="chart-container"></div>
-</div>
-
-<div class="data-tile">
-  <h4 class="tile-header">Air Quality Index (AQI)</h4>
-  <div id="gaugeAQI" class="gauge-container"></div>
-  <div id="chartAQI" class="chart-container"></div>
-</div>
-
-<div class="data-tile">
-  <h4 class="tile-header">MQ Gas Index</h4>
-  <div id="gaugeMQ" class="gauge-container"></div>
-  <div id="chartMQ" class="chart-container"></div>
-</div>
-
-</section>
+<!-- Tiles are built from /api/sensors by loadSensors() -->
+<section class="data-grid" id="dataGrid"></section>
 
 <div class="log-panel">
     <div class="log-header">
@@ -5,15 +5,18 @@
 #include <AsyncTCP.h>
 #include <ESPAsyncWebServer.h>
 #include <PubSubClient.h>
-#include <Adafruit_BME280.h>
-#include <GP2YDustSensor.h>
+#include <ArduinoJson.h>
+#include "bme280.h"
 #include "mq135.h"
+#include "dust_engine.h"
+#include "aqi.h"
 #include "config.h"
 
-// --- Global Sensor Instances ---
-extern Adafruit_BME280 bme;
-extern GP2YDustSensor* dustSensor;
+// --- Global Sensor Instances (sensor_*.cpp) ---
+extern Bme280 bme;
+extern DustEngine* dustSensor;
 extern MQ135* mq135;
+extern AqiEngine aqiEngine;  // PM10 / gas drivers feed their sub-indices here
 
 // --- External Objects ---
 extern AsyncWebServer server;
@@ -28,14 +31,46 @@ extern bool isWifiConnected;
 extern bool bmeInitialized;
 
 
+// --- Sample channels ---
+enum SampleChannel : uint8_t { CH_T, CH_H, CH_P, CH_PM, CH_AQI, CH_MQ, CH_PM_SD, CH_DEW, CH_HI, CH_AH, CH_SLP, CH_COUNT };
+
+struct SampleChannelInfo {
+  const char* key;    // JSON key
+  const char* label;  // dashboard title
+  const char* unit;
+  uint8_t decimals;   // rounding used in payloads
+  float spikeFloor;  // Hampel MAD floor (~1 sigma of noise), 0 = not checked
+};
+
+extern const SampleChannelInfo sampleChannels[CH_COUNT];
+
+// One acquisition of every channel, NAN when unavailable.
+// Captured on the boot-relative clock; see timebase.h.
+struct SensorSample {
+  float v[CH_COUNT];
+  uint64_t mono;  // µs since boot
+  uint32_t boot;  // boot ID the mono clock belongs to
+  uint16_t spikes;  // bit per channel flagged by the spike filter
+};
+
 // --- Data & Sensor Handling ---
+SensorSample readSensors();
+String sampleToJson(const SensorSample& s);
 String getDataJson();
-int calcAQI_PM25(float pm25);
+float safeRound(float v, int dec);
+uint32_t spikeCount(uint8_t channel);
+void deriveMetrics(SensorSample& s);  // fill the derived channels enabled in derivedMask
+void addSampleTime(JsonDocument& doc, uint32_t boot, uint64_t mono);
 
 // --- Time ---
 void setupTime();
 
-// --- Dust Sensor ---
+// --- Sensors ---
+void initSensors();                          // every driver in SensorRegistry
+void prepareSensors(unsigned long msToSample);  // start conversions due before the next sample
+void setupSensorRoutes();                    // /api/sensors
+void initBME280();
+void configureBME280();                      // apply bmeOs* / bmeFilter
 void initDustSensor();
 
 // --- Web / WebSocket ---
@@ -49,6 +84,14 @@ void handleReset(AsyncWebServerRequest* request);
 // --- WiFi ---
 void setupWiFi();
 void maintainWiFi();
+void wifiReconnect();  // credentials changed: restart the connect cycle
+const char* wifiLastConnectPath();
+uint32_t wifiLastConnectMs();
+void wifiPathStatsJson(JsonObject obj);  // attempts / successes / last connect ms per path
+void wifiRecordPublishLatency(uint32_t us);
+int wifiSmoothedRssi();
+uint32_t wifiRoamCount();
+uint32_t wifiDisconnectedMs();
 
 
 // --- MQ135 ---
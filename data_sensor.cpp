@@ -3,138 +3,197 @@
 #include "data.h"
 #include "config.h"
 #include <ArduinoJson.h>
-#include "mq135.h"
+#include "timebase.h"
+#include "spike_filter.h"
+#include "sensor_drivers.h"
+#include "aqi.h"
+#include "derived.h"
+#include "trace.h"
 
 // =====================================================================
 // Global instances
 // =====================================================================
-Adafruit_BME280 bme;
-GP2YDustSensor* dustSensor = nullptr;
-MQ135* mq135 = nullptr;
-bool bmeInitialized = false;
+RTC_DATA_ATTR AqiEngine aqiEngine;  // NowCast history survives deep sleep
 
 extern float dust_baseline;
 
+const SampleChannelInfo sampleChannels[CH_COUNT] = {
+  { "t", "Temperature", "°C", 1, 0.3f },
+  { "h", "Humidity", "%", 1, 1.5f },
+  { "p", "Pressure", "hPa", 1, 0.5f },
+  { "pm", "PM2.5", "µg/m³", 0, 10.0f },  // checked on the raw reading, before the Kalman filter
+  { "aqi", "Air Quality Index", "AQI", 0, 0.0f },
+  { "mq", "MQ Gas Index", "ppm", 0, 10.0f },
+  { "pm_sd", "PM2.5 uncertainty", "µg/m³", 1, 0.0f },  // 1-sigma uncertainty of "pm"
+  { "dp", "Dew point", "°C", 1, 0.0f },
+  { "hi", "Heat index", "°C", 1, 0.0f },
+  { "ah", "Absolute humidity", "g/m³", 2, 0.0f },
+  { "slp", "Sea-level pressure", "hPa", 1, 0.0f },
+};
+
 
 // =====================================================================
 // Utility
 // =====================================================================
-static float safeRound(float v, int dec) {
+float safeRound(float v, int dec) {
   if (!isfinite(v)) return NAN;
   float f = powf(10.0f, dec);
   return roundf(v * f) / f;
 }
 
-uint64_t nowMicros() {
-  struct timeval tv;
-  gettimeofday(&tv, NULL);
-  return (uint64_t)tv.tv_sec * 1000000ULL + tv.tv_usec;
+// "ts" (epoch µs) once the wall clock is valid, otherwise "bt"/"boot" for later fix-up
+void addSampleTime(JsonDocument& doc, uint32_t boot, uint64_t mono) {
+  uint64_t epoch;
+  if (monoToEpoch(boot, mono, epoch)) {
+    doc["ts"] = epoch;
+  } else {
+    doc["bt"] = mono;
+    doc["boot"] = boot;
+  }
 }
 
 // =====================================================================
-// AQI PM2.5
+// Spike filter: Hampel over the last SPIKE_WINDOW readings per channel
 // =====================================================================
-static int linAQI(float Cp, float Cl, float Ch, int Il, int Ih) {
-  return (int)roundf((Ih - Il) / (Ch - Cl) * (Cp - Cl) + Il);
-}
+#define SPIKE_WINDOW 7
+
+static HampelFilter<SPIKE_WINDOW> spikeFilters[CH_COUNT];
+static uint32_t spikeCounts[CH_COUNT];
 
-int calcAQI_PM25(float pm) {
-  if (pm < 0 || !isfinite(pm)) return -1;
-  if (pm <= 12.0f) return linAQI(pm, 0.0f, 12.0f, 0, 50);
-  if (pm <= 35.4f) return linAQI(pm, 12.1f, 35.4f, 51, 100);
-  if (pm <= 55.4f) return linAQI(pm, 35.5f, 55.4f, 101, 150);
-  if (pm <= 150.4f) return linAQI(pm, 55.5f, 150.4f, 151, 200);
-  if (pm <= 250.4f) return linAQI(pm, 150.5f, 250.4f, 201, 300);
-  if (pm <= 350.4f) return linAQI(pm, 250.5f, 350.4f, 301, 400);
-  return linAQI(pm, 350.5f, 500.4f, 401, 500);
+uint32_t spikeCount(uint8_t channel) {
+  return channel < CH_COUNT ? spikeCounts[channel] : 0;
 }
 
-// =====================================================================
-// Init MQ135
-// =====================================================================
-void initMQ135() {
-  if (mq135) return;
+float despike(SensorSample& s, SampleChannel ch, float x) {
+  if (!isfinite(x) || sampleChannels[ch].spikeFloor <= 0.0f || appConfig.spikePolicy == SPIKE_OFF) return x;
 
-  float r0 = appConfig.mq_rzero;
+  float median;
+  spikeFilters[ch].setFloor(sampleChannels[ch].spikeFloor);
+  if (!spikeFilters[ch].check(x, median)) return x;
 
-  if (!isfinite(r0) || r0 <= 0.0f || r0 > 10000.0f) {
-    addLog("[MQ135] Invalid RZERO, using default (80.0)");
-    r0 = 80.0f;
-  } else {
-    addLogf("[MQ135] Loaded saved RZERO=%.3f", r0);
-  }
+  spikeCounts[ch]++;
+  s.spikes |= 1 << ch;
+  addLogf("[WARN] Spike on %s: %.1f (median %.1f)", sampleChannels[ch].key, x, median);
 
-  mq135 = new MQ135(appConfig.mqADCPin,
-                    appConfig.mq_rl_kohm,
-                    r0);
+  switch (appConfig.spikePolicy) {
+    case SPIKE_REPLACE: return median;
+    case SPIKE_DROP: return NAN;
+    default: return x;
+  }
 }
 
 // =====================================================================
-// Init Dust Sensor
+// Derived drivers (sensor_drivers.h); hardware drivers are in sensor_*.cpp
 // =====================================================================
-void initDustSensor() {
-  if (dustSensor) return;
-  dustSensor = new GP2YDustSensor(GP2YDustSensorType::GP2Y1014AU0F,
-                                  appConfig.dustLEDPin,
-                                  appConfig.dustADCPin);
-  dustSensor->begin();
-
-  if (isfinite(appConfig.dust_baseline) && appConfig.dust_baseline > 0.0f) {
-    dustSensor->setBaseline(appConfig.dust_baseline);
+// NowCast over hourly buckets of the filtered PM. Until two of the last
+// three hours have data, fall back to the index of the current reading.
+void AqiDriver::read(SensorSample& s) {
+  AqiStandard std = (AqiStandard)appConfig.aqiStandard;
+  aqiEngine.addPm(AQI_PM25, monoMicros() / AQI_HOUR_US, s.v[CH_PM]);
+
+  int aqi = aqiEngine.overall(std);
+  if (aqi < 0) aqi = aqiSubIndex(std, AQI_PM25, s.v[CH_PM]);
+  if (aqi >= 0) s.v[CH_AQI] = aqi;
+}
 
-    addLogf("[DustSensor] Using saved baseline=%.4f", appConfig.dust_baseline);
-  } else {
-    addLog("[DustSensor] No saved baseline, will calibrate if needed");
-  }
+// Stateless per sample; also run on samples restored from the deep-sleep ring
+void deriveMetrics(SensorSample& s) {
+  uint8_t mask = appConfig.derivedMask;
+  float t = s.v[CH_T], h = s.v[CH_H];
+  if (mask & DERIVE_DEW_POINT) s.v[CH_DEW] = safeRound(dewPoint(t, h), 1);
+  if (mask & DERIVE_HEAT_INDEX) s.v[CH_HI] = safeRound(heatIndex(t, h), 1);
+  if (mask & DERIVE_ABS_HUMIDITY) s.v[CH_AH] = safeRound(absoluteHumidity(t, h), 2);
+  if (mask & DERIVE_SEA_LEVEL) s.v[CH_SLP] = safeRound(seaLevelPressure(s.v[CH_P], t, appConfig.altitude), 1);
+}
 
-  if (isfinite(appConfig.dust_calibration) && appConfig.dust_calibration > 0.0f) {
-    dustSensor->setCalibrationFactor(appConfig.dust_calibration);
-    addLogf("[DustSensor] Using saved CalibrationFactor=%4f", appConfig.dust_calibration);
-  } else {
-    addLog("[DustSensor] No saved CalibrationFactor, will CalibrationFactor if needed");
-  }
+void DerivedDriver::read(SensorSample& s) {
+  deriveMetrics(s);
 }
 
 // =====================================================================
-// JSON generator for MQTT (small payload)
+// Sensor acquisition
 // =====================================================================
-String getDataJson() {
-  float t = NAN, h = NAN, p = NAN;
+void initSensors() {
+  SensorRegistry::init();
+}
 
-  if (bmeInitialized) {
-    t = safeRound(bme.readTemperature(), 1);
-    h = safeRound(bme.readHumidity(), 1);
-    p = safeRound(bme.readPressure() / 100.0f, 1);
-  }
+void prepareSensors(unsigned long msToSample) {
+  SensorRegistry::schedule(msToSample);
+}
+
+SensorSample readSensors() {
+  TRACE_SCOPE(TR_SAMPLE);
+  SensorSample s;
+  for (uint8_t i = 0; i < CH_COUNT; i++) s.v[i] = NAN;
+  s.spikes = 0;
 
-  uint16_t pm = dustSensor ? dustSensor->getDustDensity() : 0;
-  int aqi = calcAQI_PM25(pm);
+  SensorRegistry::read(s);
 
-  float mqIndex = NAN;
-  if (mq135 && isfinite(t) && isfinite(h)) {
-    mqIndex = mq135->getCorrectedIndex(t, h);
-    mqIndex = safeRound(mqIndex, 0);
+  s.mono = monoMicros();
+  s.boot = bootId();
+
+  char line[160];
+  int len = snprintf(line, sizeof(line), "[DEBUG]");
+  for (uint8_t i = 0; i < CH_COUNT && len < (int)sizeof(line); i++) {
+    if (!(SensorRegistry::CHANNELS & SENSOR_CH(i))) continue;
+    len += snprintf(line + len, sizeof(line) - len, " %s=%.*f", sampleChannels[i].key, sampleChannels[i].decimals, s.v[i]);
   }
+  if (len < (int)sizeof(line)) SensorRegistry::debug(line + len, sizeof(line) - len);
+  addLog(line);
 
-  uint64_t ts = nowMicros();
+  return s;
+}
 
-  StaticJsonDocument<256> doc;
+// =====================================================================
+// JSON generator for MQTT (small payload)
+// =====================================================================
+String sampleToJson(const SensorSample& s) {
+  StaticJsonDocument<384> doc;
   doc["id"] = appConfig.deviceId;
-  if (isfinite(t)) doc["t"] = t;
-  if (isfinite(h)) doc["h"] = h;
-  if (isfinite(p)) doc["p"] = p;
 
-  doc["pm"] = pm;
-  doc["aqi"] = aqi;
-
-  if (isfinite(mqIndex)) doc["mq"] = mqIndex;
+  for (uint8_t i = 0; i < CH_COUNT; i++) {
+    float v = s.v[i];
+    if (!(SensorRegistry::CHANNELS & SENSOR_CH(i)) || !isfinite(v)) continue;
+    if (sampleChannels[i].decimals == 0) doc[sampleChannels[i].key] = (long)lroundf(v);
+    else doc[sampleChannels[i].key] = v;
+  }
 
-  doc["ts"] = ts;
+  if (s.spikes) doc["spk"] = s.spikes;
+  addSampleTime(doc, s.boot, s.mono);
 
   String json;
   serializeJson(doc, json);
+  return json;
+}
 
-  addLogf("[DEBUG] T=%.1f H=%.1f P=%.1f PM=%u AQI=%d MQ=%.0f", t, h, p, pm, aqi, mqIndex);
+String getDataJson() {
+  return sampleToJson(readSensors());
+}
 
-  return json;
+// =====================================================================
+// Sensor metadata for the dashboard
+// =====================================================================
+void describeSensor(JsonArray out, const char* name, bool ready, uint16_t channels) {
+  JsonObject o = out.createNestedObject();
+  o["name"] = name;
+  o["ready"] = ready;
+  JsonArray fields = o.createNestedArray("fields");
+  for (uint8_t i = 0; i < CH_COUNT; i++) {
+    if (!(channels & SENSOR_CH(i))) continue;
+    JsonObject f = fields.createNestedObject();
+    f["key"] = sampleChannels[i].key;
+    f["label"] = sampleChannels[i].label;
+    f["unit"] = sampleChannels[i].unit;
+    f["decimals"] = sampleChannels[i].decimals;
+  }
+}
+
+void setupSensorRoutes() {
+  server.on("/api/sensors", HTTP_GET, [](AsyncWebServerRequest* request) {
+    StaticJsonDocument<1024> doc;
+    SensorRegistry::describe(doc.createNestedArray("sensors"));
+    String json;
+    serializeJson(doc, json);
+    request->send(200, "application/json", json);
+  });
 }
@@ -0,0 +1,71 @@
+// derived.h
+#pragma once
+#include <math.h>
+
+#include "mq135_math.h"
+
+// =====================================================================
+// Derived meteorological metrics from t (°C), h (%RH), p (hPa).
+// Pure logic, no hardware access. log/exp/pow go through the mq135_math
+// tables; their error (< 1.2e-4 relative) is far below the error bounds
+// of the formulas themselves, given next to each function.
+// =====================================================================
+
+// Magnus coefficients (Alduchov & Eskridge 1996): saturation vapour
+// pressure within 0.4% of the reference formula over -40..50 °C
+#define MAGNUS_A 17.625f
+#define MAGNUS_B 243.04f  // °C
+#define MAGNUS_C 6.1094f  // hPa
+
+#define LN2 0.69314718f
+#define LOG2E 1.44269504f
+
+// Saturation vapour pressure over water, hPa
+inline float saturationVapourPressure(float t) {
+  return MAGNUS_C * mqmath::fastExp2(LOG2E * MAGNUS_A * t / (MAGNUS_B + t));
+}
+
+// Dew point, °C. Within 0.1 °C of the Magnus inverse over -40..50 °C
+inline float dewPoint(float t, float rh) {
+  if (!isfinite(t) || !(rh > 0.0f)) return NAN;
+  float g = LN2 * mqmath::fastLog2(rh / 100.0f) + MAGNUS_A * t / (MAGNUS_B + t);
+  return MAGNUS_B * g / (MAGNUS_A - g);
+}
+
+// Absolute humidity, g/m³ (ideal gas, water vapour R = 461.5 J/kg/K)
+inline float absoluteHumidity(float t, float rh) {
+  if (!isfinite(t) || !isfinite(rh)) return NAN;
+  float e = rh / 100.0f * saturationVapourPressure(t);
+  return 216.7f * e / (t + 273.15f);
+}
+
+// Heat index, °C: NWS Rothfusz regression with its low-humidity and
+// high-humidity adjustments, and the simple Steadman form below 80 °F.
+// The regression itself is good to about ±0.7 °C (±1.3 °F)
+inline float heatIndex(float t, float rh) {
+  if (!isfinite(t) || !isfinite(rh)) return NAN;
+  float f = t * 1.8f + 32.0f;
+
+  float hi = 0.5f * (f + 61.0f + (f - 68.0f) * 1.2f + rh * 0.094f);
+  if ((hi + f) / 2.0f >= 80.0f) {
+    hi = -42.379f + 2.04901523f * f + 10.14333127f * rh - 0.22475541f * f * rh - 6.83783e-3f * f * f -
+         5.481717e-2f * rh * rh + 1.22874e-3f * f * f * rh + 8.5282e-4f * f * rh * rh - 1.99e-6f * f * f * rh * rh;
+    if (rh < 13.0f && f >= 80.0f && f <= 112.0f) {
+      hi -= (13.0f - rh) / 4.0f * sqrtf((17.0f - fabsf(f - 95.0f)) / 17.0f);
+    } else if (rh > 85.0f && f >= 80.0f && f <= 87.0f) {
+      hi += (rh - 85.0f) / 10.0f * (87.0f - f) / 5.0f;
+    }
+  }
+  return (hi - 32.0f) / 1.8f;
+}
+
+// Sea-level pressure, hPa: barometric formula with the standard lapse
+// rate (0.0065 K/m) and the station temperature. The power-curve table
+// adds under 0.1 hPa up to 3000 m; the fixed lapse rate is the larger
+// error at altitude
+inline float seaLevelPressure(float p, float t, float altitude) {
+  if (!isfinite(p) || !isfinite(t)) return NAN;
+  if (altitude == 0.0f) return p;
+  float lh = 0.0065f * altitude;
+  return mqmath::powerCurve(p, -5.257f, 1.0f - lh / (t + lh + 273.15f));
+}
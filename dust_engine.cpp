@@ -0,0 +1,107 @@
+// dust_engine.cpp
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "dust_engine.h"
+#include "adc_dma.h"
+#include "config.h"
+
+// The ISR only knows the one engine instance
+static TaskHandle_t pulseTask = nullptr;
+
+DustEngine::DustEngine(uint8_t ledPin, uint8_t adcPin)
+: _ledPin(ledPin), _adcPin(adcPin) {}
+
+// =====================================================================
+// Timer ISR -> pulse task
+// =====================================================================
+void IRAM_ATTR DustEngine::onTimer() {
+  BaseType_t woken = pdFALSE;
+  if (pulseTask) vTaskNotifyGiveFromISR(pulseTask, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+void DustEngine::taskEntry(void *param) {
+  DustEngine *self = (DustEngine *)param;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    self->pulse();
+  }
+}
+
+// LED is active low. Runs at top priority, so the 280 µs point only
+// moves by interrupt latency; a pulse is skipped (not delayed) if an
+// MQ135 burst holds the ADC.
+void DustEngine::pulse() {
+  if (!adcTryLock()) {
+    _skipped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  digitalWrite(_ledPin, LOW);
+  delayMicroseconds(DUST_SAMPLE_DELAY_US);
+  uint16_t raw = analogRead(_adcPin);
+  delayMicroseconds(DUST_PULSE_US - DUST_SAMPLE_DELAY_US);
+  digitalWrite(_ledPin, HIGH);
+
+  adcUnlock();
+  _acc.add(raw);
+}
+
+void DustEngine::begin() {
+  if (_task) return;
+
+  pinMode(_ledPin, OUTPUT);
+  digitalWrite(_ledPin, HIGH);
+
+  xTaskCreate(taskEntry, "DustPulse", 2048, this, configMAX_PRIORITIES - 1, &_task);
+  pulseTask = _task;
+
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  _timer = timerBegin(1000000);  // 1 MHz tick
+  timerAttachInterrupt(_timer, onTimer);
+  timerAlarm(_timer, DUST_PERIOD_US, true, 0);
+#else
+  _timer = timerBegin(1, 80, true);  // 80 MHz APB / 80 = 1 MHz tick
+  timerAttachInterrupt(_timer, onTimer, true);
+  timerAlarmWrite(_timer, DUST_PERIOD_US, true);
+  timerAlarmEnable(_timer);
+#endif
+
+  addLogf("[DustSensor] Pulse engine started (%u us period, sample at %u us)", DUST_PERIOD_US, DUST_SAMPLE_DELAY_US);
+}
+
+// =====================================================================
+// Conversion
+// =====================================================================
+uint16_t DustEngine::getDustDensity() {
+  DustAccumulator::Snapshot now = _acc.snapshot();
+  uint32_t n = now.count - _last.count;
+  uint32_t sum = now.sum - _last.sum;
+  _last = now;
+  if (n == 0) return _lastDensity;  // no pulse since the last read
+
+  float volts = (sum / (float)n) * (DUST_VREF / DUST_ADC_MAX);
+  if (!isfinite(_candidate) || volts < _candidate) _candidate = volts;
+
+  float density = (volts - _baseline) / DUST_SENSITIVITY * 100.0f * _calibration;
+  _lastDensity = density > 0.0f ? (uint16_t)lroundf(density) : 0;
+  return _lastDensity;
+}
+
+void DustEngine::setBaseline(float zeroDustVoltage) {
+  if (isfinite(zeroDustVoltage) && zeroDustVoltage > 0.0f) _baseline = zeroDustVoltage;
+}
+
+float DustEngine::getBaseline() {
+  return _baseline;
+}
+
+float DustEngine::getBaselineCandidate() {
+  return isfinite(_candidate) ? _candidate : 0.0f;
+}
+
+void DustEngine::setCalibrationFactor(float factor) {
+  if (isfinite(factor) && factor > 0.0f) _calibration = factor;
+}
@@ -0,0 +1,95 @@
+// dust_engine.h
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+// =====================================================================
+// Background GP2Y1014 pulse-and-sample engine.
+// A hardware timer fires every DUST_PERIOD_US; its ISR wakes a
+// high-priority task that drives the LED pulse and samples the output
+// DUST_SAMPLE_DELAY_US into it, so timing no longer depends on loop().
+// Samples go into a single-producer accumulator that readers drain
+// without locking; getDustDensity() returns the mean since the last call.
+// =====================================================================
+#define DUST_PERIOD_US 10000      // datasheet cycle: 10 ms
+#define DUST_SAMPLE_DELAY_US 280  // sample point inside the pulse
+#define DUST_PULSE_US 320         // LED on time
+
+#define DUST_VREF 3.3f
+#define DUST_ADC_MAX 4095.0f
+#define DUST_SENSITIVITY 0.5f      // V per 100 µg/m³ (GP2Y1014AU0F)
+#define DUST_DEFAULT_BASELINE 0.6f // zero-dust output voltage
+
+// Monotonic totals guarded by a sequence counter. Only the pulse task
+// writes; any number of readers take consistent snapshots.
+class DustAccumulator {
+public:
+  struct Snapshot {
+    uint32_t count;
+    uint32_t sum;  // raw ADC counts, wraps; use differences
+  };
+
+  void add(uint16_t raw) {
+    uint32_t s = _seq.load(std::memory_order_relaxed);
+    _seq.store(s + 1, std::memory_order_relaxed);  // odd: write in progress
+    std::atomic_thread_fence(std::memory_order_release);  // keeps the data stores after it
+    _count.store(_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    _sum.store(_sum.load(std::memory_order_relaxed) + raw, std::memory_order_relaxed);
+    _seq.store(s + 2, std::memory_order_release);
+  }
+
+  Snapshot snapshot() const {
+    Snapshot snap;
+    uint32_t before, after;
+    do {
+      before = _seq.load(std::memory_order_acquire);
+      snap.count = _count.load(std::memory_order_relaxed);
+      snap.sum = _sum.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);  // keeps the data loads before it
+      after = _seq.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    return snap;
+  }
+
+private:
+  std::atomic<uint32_t> _seq{0};
+  std::atomic<uint32_t> _count{0};
+  std::atomic<uint32_t> _sum{0};
+};
+
+class DustEngine {
+public:
+  DustEngine(uint8_t ledPin, uint8_t adcPin);
+
+  void begin();  // starts the timer and the pulse task
+
+  // Mean density (µg/m³) of the pulses since the previous call
+  uint16_t getDustDensity();
+
+  void setBaseline(float zeroDustVoltage);
+  float getBaseline();
+  float getBaselineCandidate();  // lowest window voltage seen
+  void setCalibrationFactor(float factor);
+
+  uint32_t pulseCount() const { return _acc.snapshot().count; }
+  uint32_t skippedCount() const { return _skipped.load(std::memory_order_relaxed); }
+
+private:
+  uint8_t _ledPin;
+  uint8_t _adcPin;
+  float _baseline = DUST_DEFAULT_BASELINE;
+  float _candidate = NAN;
+  float _calibration = 1.0f;
+  uint16_t _lastDensity = 0;
+
+  DustAccumulator _acc;
+  DustAccumulator::Snapshot _last = { 0, 0 };
+  std::atomic<uint32_t> _skipped{0};
+
+  TaskHandle_t _task = nullptr;
+  hw_timer_t *_timer = nullptr;
+
+  static void taskEntry(void *param);
+  static void onTimer();
+  void pulse();
+};
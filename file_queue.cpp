@@ -0,0 +1,296 @@
+// file_queue.cpp
+#include <Arduino.h>
+#include <FS.h>
+
+#include "file_queue.h"
+
+#define CURSOR_MAGIC 0x51435552UL  // "QCUR"
+#define COPY_CHUNK 256
+
+FileQueue::FileQueue(fs::FS &fs, const char *prefix) : _fs(fs), _prefix(prefix) {}
+
+void FileQueue::dataPath(uint32_t gen, char *out) const {
+  snprintf(out, QUEUE_PATH_MAX, "%s.%lu", _prefix, (unsigned long)gen);
+}
+
+void FileQueue::slotPath(uint8_t slot, char *out) const {
+  snprintf(out, QUEUE_PATH_MAX, "%s.c%u", _prefix, slot);
+}
+
+// FNV-1a over everything but the check word
+uint32_t FileQueue::checksum(const Cursor &c) {
+  const uint8_t *p = (const uint8_t *)&c;
+  uint32_t h = 2166136261UL;
+  for (size_t i = 0; i < offsetof(Cursor, check); i++) h = (h ^ p[i]) * 16777619UL;
+  return h;
+}
+
+// A record is one JSON object; anything else is a torn write. A tear can
+// end on an inner '}', so the brackets must balance and close only at the
+// end. Brackets inside strings do not count.
+bool FileQueue::wellFormed(const String &line) {
+  size_t n = line.length();
+  if (n < 2 || line[0] != '{' || line[n - 1] != '}') return false;
+
+  int depth = 0;
+  bool inString = false;
+  for (size_t i = 0; i < n; i++) {
+    char ch = line[i];
+    if (inString) {
+      if (ch == '\\') i++;
+      else if (ch == '"') inString = false;
+    } else if (ch == '"') {
+      inString = true;
+    } else if (ch == '{' || ch == '[') {
+      depth++;
+    } else if (ch == '}' || ch == ']') {
+      if (--depth == 0 && i != n - 1) return false;
+    }
+  }
+  return depth == 0 && !inString;
+}
+
+// =====================================================================
+// Cursor slots
+// =====================================================================
+bool FileQueue::loadSlot(uint8_t slot, Cursor &c) {
+  char path[QUEUE_PATH_MAX];
+  slotPath(slot, path);
+  if (!_fs.exists(path)) return false;
+
+  File f = _fs.open(path, "r");
+  if (!f) return false;
+  size_t n = f.readBytes((char *)&c, sizeof(c));
+  f.close();
+  return n == sizeof(c) && c.magic == CURSOR_MAGIC && c.check == checksum(c);
+}
+
+bool FileQueue::commit(uint32_t gen, uint32_t offset) {
+  Cursor c = { CURSOR_MAGIC, _seq + 1, gen, offset, 0 };
+  c.check = checksum(c);
+
+  char path[QUEUE_PATH_MAX];
+  slotPath(c.seq & 1, path);
+  File f = _fs.open(path, "w");
+  if (!f) return false;
+  size_t n = f.write((const uint8_t *)&c, sizeof(c));
+  f.close();
+
+  _counters.cursorWrites++;
+  _counters.bytesWritten += n;
+  if (n != sizeof(c)) return false;
+  _seq = c.seq;
+  return true;
+}
+
+// =====================================================================
+// Recovery
+// =====================================================================
+bool FileQueue::begin() {
+  Cursor a, b;
+  bool va = loadSlot(0, a), vb = loadSlot(1, b);
+  if (va && (!vb || a.seq > b.seq)) {
+    _seq = a.seq; _gen = a.gen; _offset = a.offset;
+  } else if (vb) {
+    _seq = b.seq; _gen = b.gen; _offset = b.offset;
+  } else {
+    _seq = 0; _gen = 0; _offset = 0;
+  }
+
+  // gen + 1: compaction that never committed; gen - 1: committed, not yet removed
+  char path[QUEUE_PATH_MAX];
+  dataPath(_gen + 1, path);
+  if (_fs.exists(path)) _fs.remove(path);
+  if (_gen > 0) {
+    dataPath(_gen - 1, path);
+    if (_fs.exists(path)) _fs.remove(path);
+  }
+
+  _size = 0;
+  dataPath(_gen, path);
+  if (_fs.exists(path)) {
+    File f = _fs.open(path, "r");
+    if (f) {
+      _size = f.size();
+      char last = '\n';
+      if (_size > 0 && f.seek(_size - 1)) f.readBytes(&last, 1);
+      f.close();
+
+      // Torn last append: end it so the next record starts on a fresh line
+      if (last != '\n') {
+        File w = _fs.open(path, "a");
+        if (w) {
+          _size += w.print("\n");
+          _counters.bytesWritten++;
+          w.close();
+        }
+      }
+    }
+  }
+  if (_offset > _size) _offset = 0;  // cursor from another file: resend rather than lose
+
+  _ready = true;
+  return true;
+}
+
+bool FileQueue::adopt(const char *path) {
+  if (!_ready || !empty() || !_fs.exists(path)) return false;
+  if (_size > 0 && !compact()) return false;
+
+  char data[QUEUE_PATH_MAX];
+  dataPath(_gen, data);
+  if (_fs.exists(data)) _fs.remove(data);
+  if (!_fs.rename(path, data)) return false;
+  return begin();
+}
+
+void FileQueue::erase() {
+  char path[QUEUE_PATH_MAX];
+  dataPath(_gen, path);
+  _fs.remove(path);
+  for (uint8_t slot = 0; slot < 2; slot++) {
+    slotPath(slot, path);
+    _fs.remove(path);
+  }
+  _seq = _gen = _offset = _size = 0;
+  _counters = {};
+  _ready = false;
+}
+
+// =====================================================================
+// Append / drain
+// =====================================================================
+bool FileQueue::append(const String &record) {
+  if (!_ready) return false;
+
+  uint32_t len = record.length() + 1;
+  if (len > _maxBytes) {
+    _counters.dropped++;
+    return false;
+  }
+  if (pendingBytes() + len > _maxBytes) dropOldest(len);
+
+  char path[QUEUE_PATH_MAX];
+  dataPath(_gen, path);
+  File f = _fs.open(path, "a");
+  if (!f) return false;
+  size_t n = f.print(record);
+  n += f.print("\n");
+  f.close();
+
+  _size += n;
+  _counters.appends++;
+  _counters.appendBytes += len;
+  _counters.bytesWritten += n;
+  return n == len;
+}
+
+uint32_t FileQueue::drain(PublishFn publish, uint32_t maxRecords) {
+  if (!_ready || empty()) return 0;
+
+  char path[QUEUE_PATH_MAX];
+  dataPath(_gen, path);
+  File f = _fs.open(path, "r");
+  if (!f) return 0;
+  f.seek(_offset);
+
+  uint32_t sent = 0, sinceCommit = 0, offset = _offset;
+  while (sent < maxRecords && offset < _size) {
+    String line = f.readStringUntil('\n');
+    uint32_t next = offset + line.length() + 1;
+
+    if (!wellFormed(line)) {
+      _counters.corrupt++;
+      offset = next;
+      continue;
+    }
+    if (!publish(line)) break;
+
+    offset = next;
+    sent++;
+    _counters.published++;
+    if (++sinceCommit >= QUEUE_CURSOR_EVERY) {
+      commit(_gen, offset);
+      _offset = offset;
+      sinceCommit = 0;
+    }
+  }
+  f.close();
+
+  // A failed commit only means these may be sent again after a reboot
+  if (offset != _offset) {
+    commit(_gen, offset);
+    _offset = offset;
+  }
+  if (_size > 0 && (empty() || _offset > _maxBytes / 2)) compact();
+  return sent;
+}
+
+// Frees a quarter of the cap at once, so a long outage costs one cursor
+// commit per quarter rather than one per append
+bool FileQueue::dropOldest(uint32_t need) {
+  char path[QUEUE_PATH_MAX];
+  dataPath(_gen, path);
+  File f = _fs.open(path, "r");
+  if (!f) return false;
+  f.seek(_offset);
+
+  uint32_t target = _maxBytes - _maxBytes / 4;
+  uint32_t offset = _offset;
+  while (offset < _size && (_size - offset) + need > target) {
+    String line = f.readStringUntil('\n');
+    offset += line.length() + 1;
+    _counters.dropped++;
+  }
+  f.close();
+
+  commit(_gen, offset);
+  _offset = offset;
+  if (_offset > _maxBytes / 2) compact();
+  return true;
+}
+
+// =====================================================================
+// Compaction: the unsent tail moves to gen + 1, committed by the cursor
+// =====================================================================
+bool FileQueue::compact() {
+  char src[QUEUE_PATH_MAX], dst[QUEUE_PATH_MAX];
+  dataPath(_gen, src);
+  dataPath(_gen + 1, dst);
+
+  uint32_t copied = 0;
+  if (!empty()) {
+    File in = _fs.open(src, "r");
+    File out = _fs.open(dst, "w");
+    if (!in || !out) {
+      if (in) in.close();
+      if (out) out.close();
+      _fs.remove(dst);
+      return false;
+    }
+    in.seek(_offset);
+
+    char buf[COPY_CHUNK];
+    size_t n;
+    while ((n = in.readBytes(buf, sizeof(buf))) > 0) copied += out.write((const uint8_t *)buf, n);
+    in.close();
+    out.close();
+    _counters.bytesWritten += copied;
+
+    if (copied != pendingBytes()) {
+      _fs.remove(dst);
+      return false;
+    }
+  }
+
+  if (!commit(_gen + 1, 0)) {
+    _fs.remove(dst);
+    return false;
+  }
+  _fs.remove(src);
+  _gen++;
+  _offset = 0;
+  _size = copied;
+  _counters.compactions++;
+  return true;
+}
@@ -0,0 +1,101 @@
+// file_queue.h
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+
+// =====================================================================
+// Power-loss-safe record queue on a flash filesystem.
+// Records are newline-terminated lines appended to "<prefix>.<gen>";
+// nothing before the read cursor is ever rewritten in place. The cursor
+// (generation + byte offset) is committed to one of two slot files,
+// alternating, each carrying a sequence number and checksum, so a torn
+// cursor write falls back to the previous one.
+//
+// What a power cut at any write can cost:
+//   append        the record being written (its fragment is skipped)
+//   cursor commit up to QUEUE_CURSOR_EVERY records are sent again
+//   compaction    nothing: the old generation stays live until the new
+//                 cursor is committed; leftovers are removed by begin()
+// Delivery is at-least-once; records are never reordered.
+//
+// Any fs::FS works (SPIFFS, LittleFS, or a simulated one).
+// =====================================================================
+#define QUEUE_CURSOR_EVERY 16  // published records per cursor commit
+#define QUEUE_PATH_MAX 24
+
+class FileQueue {
+public:
+  typedef bool (*PublishFn)(const String &record);
+
+  struct Counters {
+    uint32_t appends;
+    uint32_t appendBytes;   // payload, including newlines
+    uint32_t bytesWritten;  // everything: records, cursors, compaction copies
+    uint32_t cursorWrites;
+    uint32_t compactions;
+    uint32_t published;
+    uint32_t dropped;  // oldest records discarded to stay under maxBytes
+    uint32_t corrupt;  // torn or malformed lines skipped
+  };
+
+  FileQueue(fs::FS &fs, const char *prefix);
+
+  // Recover state after boot: pick the newest valid cursor, delete
+  // leftovers of an interrupted compaction, terminate a torn last record
+  bool begin();
+
+  // Move an existing line file in as the backlog (only when empty)
+  bool adopt(const char *path);
+
+  // Delete the data and cursor files and reset the counters; begin()
+  // again before reuse
+  void erase();
+
+  void setMaxBytes(uint32_t maxBytes) { _maxBytes = maxBytes; }
+
+  // Oldest records are dropped if the backlog would exceed maxBytes
+  bool append(const String &record);
+
+  // Publishes pending records oldest first until publish() fails or
+  // maxRecords were sent; returns the number sent
+  uint32_t drain(PublishFn publish, uint32_t maxRecords = UINT32_MAX);
+
+  uint32_t pendingBytes() const { return _size - _offset; }
+  bool empty() const { return _size == _offset; }
+  const Counters &counters() const { return _counters; }
+
+  // bytesWritten / appendBytes
+  float writeAmplification() const {
+    return _counters.appendBytes ? (float)_counters.bytesWritten / _counters.appendBytes : 0.0f;
+  }
+
+private:
+  struct Cursor {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t gen;
+    uint32_t offset;
+    uint32_t check;
+  };
+
+  fs::FS &_fs;
+  const char *_prefix;
+  uint32_t _maxBytes = UINT32_MAX;
+  uint32_t _seq = 0;
+  uint32_t _gen = 0;
+  uint32_t _offset = 0;  // next unsent byte in the current generation
+  uint32_t _size = 0;    // bytes in the current generation
+  bool _ready = false;
+  Counters _counters = {};
+
+  void dataPath(uint32_t gen, char *out) const;
+  void slotPath(uint8_t slot, char *out) const;
+
+  bool loadSlot(uint8_t slot, Cursor &c);
+  bool commit(uint32_t gen, uint32_t offset);
+  bool compact();  // copy the unsent tail into gen + 1
+  bool dropOldest(uint32_t need);
+
+  static uint32_t checksum(const Cursor &c);
+  static bool wellFormed(const String &line);
+};
@@ -0,0 +1,155 @@
+// heap_monitor.cpp
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include <esp_heap_caps.h>
+
+#include "heap_monitor.h"
+#include "config.h"
+
+extern AsyncWebServer server;
+
+#define HEAP_CAPS MALLOC_CAP_8BIT
+
+static const char* const heapTagNames[HEAP_TAG_COUNT] = {
+  "sample", "mqtt", "queue", "ws", "log", "config"
+};
+
+// =====================================================================
+// Snapshots. Written only from loop(); the web handler reads them
+// unlocked, a torn value is harmless.
+// =====================================================================
+struct HeapPoint {
+  uint32_t atS;
+  uint32_t freeBytes;
+  uint32_t largest;
+};
+
+static HeapSnapshot lastSnap = {};
+static uint32_t minLargest = UINT32_MAX;
+static float maxFrag = 0.0f;
+static unsigned long lastSnapshotAt = 0;
+static uint16_t snapshotCount = 0;
+
+static HeapPoint history[HEAP_HISTORY];
+static uint8_t historyHead = 0;
+static uint8_t historyCount = 0;
+
+// =====================================================================
+// Per-tag net change, loop() task only
+// =====================================================================
+struct HeapTagStats {
+  uint32_t calls;
+  int32_t net;    // bytes still held, summed over all calls
+  int32_t last;
+  int32_t worst;  // largest single-call growth
+};
+
+static HeapTagStats tagStats[HEAP_TAG_COUNT];
+static HeapScope *currentScope = nullptr;
+static TaskHandle_t loopTask = nullptr;
+
+HeapSnapshot heapSnapshot() {
+  HeapSnapshot s;
+  s.freeBytes = heap_caps_get_free_size(HEAP_CAPS);
+  s.minFree = heap_caps_get_minimum_free_size(HEAP_CAPS);
+  s.largest = heap_caps_get_largest_free_block(HEAP_CAPS);
+  s.frag = s.freeBytes > 0 ? 1.0f - (float)s.largest / s.freeBytes : 0.0f;
+  return s;
+}
+
+void heapMonitorInit() {
+  loopTask = xTaskGetCurrentTaskHandle();
+  lastSnap = heapSnapshot();
+  lastSnapshotAt = millis();
+}
+
+void heapMonitorLoop() {
+  if (millis() - lastSnapshotAt < HEAP_SNAPSHOT_MS) return;
+  lastSnapshotAt = millis();
+
+  lastSnap = heapSnapshot();
+  if (lastSnap.largest < minLargest) minLargest = lastSnap.largest;
+  if (lastSnap.frag > maxFrag) maxFrag = lastSnap.frag;
+
+  if (snapshotCount++ % HEAP_HISTORY_EVERY != 0) return;
+  history[historyHead] = { millis() / 1000, lastSnap.freeBytes, lastSnap.largest };
+  historyHead = (historyHead + 1) % HEAP_HISTORY;
+  if (historyCount < HEAP_HISTORY) historyCount++;
+
+  addLogf("[DEBUG] [HEAP] free %u, min %u, largest %u, frag %.2f", lastSnap.freeBytes, lastSnap.minFree,
+          lastSnap.largest, lastSnap.frag);
+}
+
+// =====================================================================
+// Scopes
+// =====================================================================
+HeapScope::HeapScope(HeapTag tag) : _parent(nullptr), _startFree(0), _childNet(0), _tag(tag), _active(false) {
+  if (!appConfig.heapTrack || xTaskGetCurrentTaskHandle() != loopTask) return;
+  _active = true;
+  _parent = currentScope;
+  currentScope = this;
+  _startFree = heap_caps_get_free_size(HEAP_CAPS);
+}
+
+HeapScope::~HeapScope() {
+  if (!_active) return;
+  int32_t net = _startFree - (int32_t)heap_caps_get_free_size(HEAP_CAPS);
+  int32_t own = net - _childNet;
+
+  HeapTagStats &t = tagStats[_tag];
+  t.calls++;
+  t.net += own;
+  t.last = own;
+  if (own > t.worst) t.worst = own;
+
+  if (_parent) _parent->_childNet += net;
+  currentScope = _parent;
+}
+
+// =====================================================================
+// Report
+// =====================================================================
+static float round2(float x) {
+  return roundf(x * 100.0f) / 100.0f;
+}
+
+void heapMonitorJson(JsonObject obj) {
+  HeapSnapshot now = heapSnapshot();
+  obj["free"] = now.freeBytes;
+  obj["min_free"] = now.minFree;
+  obj["largest"] = now.largest;
+  obj["frag"] = round2(now.frag);
+  obj["min_largest"] = minLargest < now.largest ? minLargest : now.largest;
+  obj["max_frag"] = round2(maxFrag > now.frag ? maxFrag : now.frag);
+  obj["snapshot_ms"] = HEAP_SNAPSHOT_MS;
+
+  obj["tracking"] = (bool)appConfig.heapTrack;
+  JsonObject tags = obj.createNestedObject("tags");
+  for (uint8_t i = 0; i < HEAP_TAG_COUNT; i++) {
+    JsonObject o = tags.createNestedObject(heapTagNames[i]);
+    o["calls"] = tagStats[i].calls;
+    o["net"] = tagStats[i].net;
+    o["last"] = tagStats[i].last;
+    o["worst"] = tagStats[i].worst;
+  }
+
+  JsonArray arr = obj.createNestedArray("history");  // oldest first
+  for (uint8_t k = 0; k < historyCount; k++) {
+    const HeapPoint &p = history[(historyHead + HEAP_HISTORY - historyCount + k) % HEAP_HISTORY];
+    JsonArray row = arr.createNestedArray();
+    row.add(p.atS);
+    row.add(p.freeBytes);
+    row.add(p.largest);
+  }
+}
+
+void setupHeapRoutes() {
+  server.on("/api/heap", HTTP_GET, [](AsyncWebServerRequest *request) {
+    StaticJsonDocument<3072> doc;
+    heapMonitorJson(doc.to<JsonObject>());
+    String json;
+    serializeJson(doc, json);
+    request->send(200, "application/json", json);
+  });
+}
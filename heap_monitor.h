@@ -0,0 +1,62 @@
+// heap_monitor.h
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// =====================================================================
+// Heap health: free, minimum-ever and largest free block of the 8-bit
+// heap, sampled every HEAP_SNAPSHOT_MS, with a fragmentation ratio
+// 1 - largest / free (0 = one contiguous block). A slow fall of free heap
+// is a leak; a falling largest block with steady free heap is
+// fragmentation, and is what eventually fails a String or TLS allocation.
+//
+// Per-subsystem attribution (opt-in, appConfig.heapTrack): HEAP_SCOPE(tag)
+// measures the net heap change across a block on the loop() task.
+// Nested scopes are exclusive; the inner bytes are not counted again in
+// the outer one. Other tasks allocate at the same time, so single calls
+// are noisy. A tag whose net keeps climbing over hours is the leak.
+// Buffers handed to another task (WebSocket frames, TCP segments) count
+// as growth in the scope that queued them.
+// =====================================================================
+enum HeapTag : uint8_t {
+  HEAP_SAMPLE,  // readSensors + sample JSON
+  HEAP_MQTT,    // loopMQTT, sendMQTT
+  HEAP_QUEUE,   // RAM/flash offline queue
+  HEAP_WS,      // WebSocket broadcast, sysinfo
+  HEAP_LOG,     // addLog ring and broadcast
+  HEAP_CONFIG,  // config persist / live apply
+  HEAP_TAG_COUNT
+};
+
+#define HEAP_SNAPSHOT_MS 10000UL
+#define HEAP_HISTORY 24        // history points kept
+#define HEAP_HISTORY_EVERY 30  // snapshots per history point (5 min)
+
+struct HeapSnapshot {
+  uint32_t freeBytes;
+  uint32_t minFree;  // low-water mark since boot
+  uint32_t largest;  // largest free block
+  float frag;        // 1 - largest / free
+};
+
+void heapMonitorInit();  // from setup(): remembers the loop() task
+void heapMonitorLoop();  // periodic snapshot
+HeapSnapshot heapSnapshot();
+
+class HeapScope {
+public:
+  explicit HeapScope(HeapTag tag);
+  ~HeapScope();
+
+private:
+  HeapScope *_parent;
+  int32_t _startFree;
+  int32_t _childNet;
+  HeapTag _tag;
+  bool _active;
+};
+
+#define HEAP_SCOPE(tag) HeapScope heapScope_(tag)
+
+void heapMonitorJson(JsonObject obj);
+void setupHeapRoutes();
@@ -0,0 +1,178 @@
+// loop_monitor.cpp
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include <esp_system.h>
+
+#include "loop_monitor.h"
+#include "config.h"
+#include "stats.h"
+
+extern AsyncWebServer server;
+
+static const char* const loopSectionNames[LOOP_SECTION_COUNT] = {
+  "wifi", "config", "mqtt", "ota", "ws", "send"
+};
+
+// =====================================================================
+// Per-section and whole-iteration histograms. Written only from loop();
+// the web handler reads them unlocked, a torn count is harmless.
+// =====================================================================
+static LatencyHistogram sectionHist[LOOP_SECTION_COUNT];
+static LatencyHistogram iterationHist;
+
+static uint32_t cyclesPerUs = 240;
+static uint32_t iterStart = 0;
+static uint32_t markAt = 0;
+static uint32_t iterSectionUs[LOOP_SECTION_COUNT];
+
+struct LoopStall {
+  uint32_t atMs;     // millis() when the iteration ended
+  uint32_t totalUs;
+  uint32_t worstUs;
+  uint8_t worst;     // LoopSection
+};
+
+static LoopStall stalls[LOOP_STALL_HISTORY];
+static uint8_t stallHead = 0;
+static uint32_t stallCount = 0;
+
+static bool watchdogEnabled = false;
+
+// Section in progress, kept across a watchdog reset so it can be blamed
+#define LOOP_TRACE_MAGIC 0x4C4F4F50  // "LOOP"
+RTC_NOINIT_ATTR static uint32_t rtcTraceMagic;
+RTC_NOINIT_ATTR static uint8_t rtcTraceSection;
+
+static inline uint32_t cyclesToUs(uint32_t cycles) {
+  return cycles / cyclesPerUs;
+}
+
+static inline void traceSection(uint8_t s) {
+  rtcTraceSection = s;
+}
+
+// =====================================================================
+// Setup
+// =====================================================================
+void loopMonitorInit() {
+  cyclesPerUs = ESP.getCpuFreqMHz();
+  if (cyclesPerUs == 0) cyclesPerUs = 240;
+
+  esp_reset_reason_t reason = esp_reset_reason();
+  if (rtcTraceMagic == LOOP_TRACE_MAGIC && rtcTraceSection < LOOP_SECTION_COUNT &&
+      (reason == ESP_RST_TASK_WDT || reason == ESP_RST_INT_WDT)) {
+    addLogf("[LOOP] Last reset was a watchdog timeout in section '%s'", loopSectionNames[rtcTraceSection]);
+  }
+  rtcTraceMagic = LOOP_TRACE_MAGIC;
+  traceSection(0);
+}
+
+// The core feeds it after every loop() return; default timeout is 5 s
+void loopMonitorEnableWatchdog() {
+  enableLoopWDT();
+  watchdogEnabled = true;
+  addLog("[LOOP] Task watchdog enabled for loop()");
+}
+
+void loopMonitorFeed() {
+  if (watchdogEnabled) feedLoopWDT();
+}
+
+// =====================================================================
+// Timing
+// =====================================================================
+void loopMonitorStart() {
+  iterStart = markAt = ESP.getCycleCount();
+  for (uint8_t i = 0; i < LOOP_SECTION_COUNT; i++) iterSectionUs[i] = 0;
+  traceSection(0);
+}
+
+void loopMonitorMark(LoopSection s) {
+  uint32_t now = ESP.getCycleCount();
+  uint32_t us = cyclesToUs(now - markAt);  // unsigned math survives the wrap
+  markAt = now;
+
+  sectionHist[s].add(us);
+  iterSectionUs[s] = us;
+  traceSection(s + 1 < LOOP_SECTION_COUNT ? s + 1 : 0);
+}
+
+void loopMonitorEnd() {
+  uint32_t totalUs = cyclesToUs(ESP.getCycleCount() - iterStart);
+  iterationHist.add(totalUs);
+  if (totalUs < LOOP_STALL_US) return;
+
+  uint8_t worst = 0;
+  for (uint8_t i = 1; i < LOOP_SECTION_COUNT; i++) {
+    if (iterSectionUs[i] > iterSectionUs[worst]) worst = i;
+  }
+
+  LoopStall& st = stalls[stallHead];
+  st.atMs = millis();
+  st.totalUs = totalUs;
+  st.worstUs = iterSectionUs[worst];
+  st.worst = worst;
+  stallHead = (stallHead + 1) % LOOP_STALL_HISTORY;
+  stallCount++;
+
+  addLogf("[WARN] loop() stalled %lu ms, %s took %lu ms", totalUs / 1000, loopSectionNames[worst], st.worstUs / 1000);
+}
+
+uint32_t loopMonitorP99Us() {
+  return iterationHist.percentile(0.99f);
+}
+
+uint32_t loopMonitorMaxUs() {
+  return iterationHist.max();
+}
+
+uint32_t loopMonitorStalls() {
+  return stallCount;
+}
+
+// =====================================================================
+// Reporting
+// =====================================================================
+static void histToJson(const LatencyHistogram& h, JsonObject o) {
+  o["n"] = h.count();
+  o["mean"] = h.mean();
+  o["p50"] = h.percentile(0.50f);
+  o["p90"] = h.percentile(0.90f);
+  o["p99"] = h.percentile(0.99f);
+  o["p999"] = h.percentile(0.999f);
+  o["max"] = h.max();
+}
+
+// {"unit":"us","loop":{...},"sections":{"wifi":{...},...},"stalls":[...]}
+void loopMonitorJson(JsonObject obj) {
+  obj["unit"] = "us";
+  obj["stall_us"] = LOOP_STALL_US;
+  obj["watchdog"] = watchdogEnabled;
+  histToJson(iterationHist, obj.createNestedObject("loop"));
+
+  JsonObject sec = obj.createNestedObject("sections");
+  for (uint8_t i = 0; i < LOOP_SECTION_COUNT; i++) histToJson(sectionHist[i], sec.createNestedObject(loopSectionNames[i]));
+
+  obj["stall_count"] = stallCount;
+  JsonArray arr = obj.createNestedArray("stalls");
+  uint8_t n = stallCount < LOOP_STALL_HISTORY ? stallCount : LOOP_STALL_HISTORY;
+  for (uint8_t k = 0; k < n; k++) {
+    const LoopStall& st = stalls[(stallHead + LOOP_STALL_HISTORY - 1 - k) % LOOP_STALL_HISTORY];  // newest first
+    JsonObject o = arr.createNestedObject();
+    o["at_ms"] = st.atMs;
+    o["total"] = st.totalUs;
+    o["section"] = loopSectionNames[st.worst];
+    o["section_us"] = st.worstUs;
+  }
+}
+
+void setupLoopRoutes() {
+  server.on("/api/loop", HTTP_GET, [](AsyncWebServerRequest *request) {
+    StaticJsonDocument<2048> doc;
+    loopMonitorJson(doc.to<JsonObject>());
+    String json;
+    serializeJson(doc, json);
+    request->send(200, "application/json", json);
+  });
+}
@@ -0,0 +1,34 @@
+// loop_monitor.h
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Sections of loop(), timed with the CPU cycle counter
+enum LoopSection : uint8_t {
+  LOOP_WIFI,    // maintainWiFi
+  LOOP_CONFIG,  // configPersistLoop / configApplyLoop
+  LOOP_MQTT,    // loopMQTT
+  LOOP_OTA,     // ArduinoOTA.handle
+  LOOP_WS,      // ws.cleanupClients
+  LOOP_SEND,    // sample / publish block
+  LOOP_SECTION_COUNT
+};
+
+// An iteration slower than this is logged as a stall with its worst section
+#define LOOP_STALL_US 100000UL
+#define LOOP_STALL_HISTORY 8
+
+void loopMonitorInit();             // also reports a watchdog reset from the last boot
+void loopMonitorEnableWatchdog();   // subscribes loop() to the task watchdog
+void loopMonitorFeed();             // for code that blocks inside loop()
+
+void loopMonitorStart();               // top of loop()
+void loopMonitorMark(LoopSection s);   // closes section s, opens the next one
+void loopMonitorEnd();                 // bottom of loop()
+
+uint32_t loopMonitorP99Us();
+uint32_t loopMonitorMaxUs();
+uint32_t loopMonitorStalls();
+
+void loopMonitorJson(JsonObject obj);
+void setupLoopRoutes();
@@ -0,0 +1,184 @@
+// low_power.cpp
+#include <Arduino.h>
+#include <esp_sleep.h>
+
+#include "low_power.h"
+#include "data.h"
+#include "config.h"
+#include "timebase.h"
+#include "mqtt_handler.h"
+#include "loop_monitor.h"
+
+// =====================================================================
+// RTC-memory sample ring (survives deep sleep, cleared on power-on)
+// =====================================================================
+#define LOW_POWER_RING_SIZE 96
+#define LOW_POWER_MAGIC 0x4C505231  // "LPR1"
+#define LOW_POWER_CONNECT_TIMEOUT_MS 20000
+
+#define PACK_NAN_I16 INT16_MIN
+#define PACK_NAN_U16 0xFFFF
+
+struct PackedSample {
+  uint64_t mono;
+  int16_t t10;
+  uint16_t h10;
+  uint16_t p10;
+  uint16_t pm;
+  int16_t aqi;
+  uint16_t mq;
+};
+
+struct SampleRing {
+  uint32_t magic;
+  uint32_t wakeCount;
+  uint16_t head;
+  uint16_t count;
+  PackedSample items[LOW_POWER_RING_SIZE];
+};
+
+RTC_DATA_ATTR static SampleRing rtcRing;
+
+static int16_t packI16(float v, float scale) {
+  return isfinite(v) ? (int16_t)lroundf(v * scale) : PACK_NAN_I16;
+}
+
+static uint16_t packU16(float v, float scale) {
+  return isfinite(v) && v >= 0.0f ? (uint16_t)min(lroundf(v * scale), 0xFFFEL) : PACK_NAN_U16;
+}
+
+static float unpackI16(int16_t v, float scale) {
+  return v == PACK_NAN_I16 ? NAN : v / scale;
+}
+
+static float unpackU16(uint16_t v, float scale) {
+  return v == PACK_NAN_U16 ? NAN : v / scale;
+}
+
+static void ringPush(const SensorSample &s) {
+  PackedSample &p = rtcRing.items[(rtcRing.head + rtcRing.count) % LOW_POWER_RING_SIZE];
+  p.mono = s.mono;
+  p.t10 = packI16(s.v[CH_T], 10.0f);
+  p.h10 = packU16(s.v[CH_H], 10.0f);
+  p.p10 = packU16(s.v[CH_P], 10.0f);
+  p.pm = packU16(s.v[CH_PM], 1.0f);
+  p.aqi = packI16(s.v[CH_AQI], 1.0f);
+  p.mq = packU16(s.v[CH_MQ], 1.0f);
+
+  if (rtcRing.count < LOW_POWER_RING_SIZE) rtcRing.count++;
+  else rtcRing.head = (rtcRing.head + 1) % LOW_POWER_RING_SIZE;  // overwrite oldest
+}
+
+static SensorSample ringFront() {
+  const PackedSample &p = rtcRing.items[rtcRing.head];
+  SensorSample s;
+  for (uint8_t i = 0; i < CH_COUNT; i++) s.v[i] = NAN;
+  s.spikes = 0;
+  s.v[CH_T] = unpackI16(p.t10, 10.0f);
+  s.v[CH_H] = unpackU16(p.h10, 10.0f);
+  s.v[CH_P] = unpackU16(p.p10, 10.0f);
+  s.v[CH_PM] = unpackU16(p.pm, 1.0f);
+  s.v[CH_AQI] = unpackI16(p.aqi, 1.0f);
+  s.v[CH_MQ] = unpackU16(p.mq, 1.0f);
+  deriveMetrics(s);  // not stored, cheap to recompute
+  s.mono = p.mono;
+  s.boot = bootId();  // boot ID is kept across timer wakes
+  return s;
+}
+
+static void ringPop() {
+  rtcRing.head = (rtcRing.head + 1) % LOW_POWER_RING_SIZE;
+  rtcRing.count--;
+}
+
+// =====================================================================
+// Hardware bindings for DutyCycle
+// =====================================================================
+static uint32_t halNowMs() {
+  return millis();
+}
+
+static void halStartWarmup() {
+  initSensors();
+}
+
+static bool halSample() {
+  ringPush(readSensors());
+  return true;
+}
+
+static uint16_t halBuffered() {
+  return rtcRing.count;
+}
+
+static void halStartNetwork() {
+  if (!isWifiConnected) setupWiFi();  // still up after the cold-boot config window
+  setupTime();
+  setupMQTT();
+  mqttConnectNow();  // millis() restarts every wake; do not wait out the retry interval
+}
+
+static bool halNetworkReady() {
+  maintainWiFi();
+  loopMQTT();
+  return isWifiConnected && mqttConnected();
+}
+
+static bool halPublishOne() {
+  if (!mqttPublishNow(sampleToJson(ringFront()))) return false;
+  ringPop();
+  return true;
+}
+
+static void halSleep(uint32_t ms) {
+  uint64_t us = (uint64_t)ms * 1000ULL;
+  addLogf("[LP] Sleeping %lu ms (%u buffered)", ms, rtcRing.count);
+  Serial.flush();
+
+  configPersistFlush();
+  timebasePrepareSleep(us);
+  esp_sleep_enable_timer_wakeup(us);
+  esp_deep_sleep_start();
+}
+
+// =====================================================================
+// Entry points
+// =====================================================================
+bool lowPowerWokeFromSleep() {
+  return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+}
+
+void runLowPowerCycle() {
+  if (rtcRing.magic != LOW_POWER_MAGIC) {
+    memset(&rtcRing, 0, sizeof(rtcRing));
+    rtcRing.magic = LOW_POWER_MAGIC;
+  }
+  rtcRing.wakeCount++;
+
+  DutyCycleConfig cfg = {
+    .wakeIntervalMs = appConfig.wakeInterval * 1000UL,
+    .warmupMs = appConfig.sensorWarmupMs,
+    .connectTimeoutMs = LOW_POWER_CONNECT_TIMEOUT_MS,
+    .publishEvery = appConfig.publishEveryN,
+    .bufferCapacity = LOW_POWER_RING_SIZE,
+  };
+
+  DutyCycleHal hal = {
+    .nowMs = halNowMs,
+    .startWarmup = halStartWarmup,
+    .sample = halSample,
+    .buffered = halBuffered,
+    .startNetwork = halStartNetwork,
+    .networkReady = halNetworkReady,
+    .publishOne = halPublishOne,
+    .sleep = halSleep,
+  };
+
+  addLogf("[LP] Wake #%u (%u buffered)", rtcRing.wakeCount, rtcRing.count);
+
+  DutyCycle cycle(cfg, hal, rtcRing.wakeCount);
+  while (cycle.step() != DUTY_DONE) {
+    delay(cycle.phase() == DUTY_WARMUP ? 5 : 1);
+    loopMonitorFeed();  // called from loop() once the config window ends
+  }
+}
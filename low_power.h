@@ -0,0 +1,111 @@
+// low_power.h
+#pragma once
+#include <stdint.h>
+
+// =====================================================================
+// Duty-cycle state machine for the deep-sleep mode.
+// Pure logic: all hardware access goes through DutyCycleHal, so the
+// sequence can be driven by a simulated clock off-target.
+// =====================================================================
+
+struct DutyCycleConfig {
+  uint32_t wakeIntervalMs;    // period between wakes
+  uint32_t warmupMs;          // sensor settle time before sampling
+  uint32_t connectTimeoutMs;  // give up on WiFi/MQTT after this long
+  uint16_t publishEvery;      // bring the radio up every N wakes
+  uint16_t bufferCapacity;    // publish early when the ring is full
+};
+
+struct DutyCycleHal {
+  uint32_t (*nowMs)();
+  void (*startWarmup)();
+  bool (*sample)();  // read sensors and append to the ring
+  uint16_t (*buffered)();
+  void (*startNetwork)();
+  bool (*networkReady)();  // also services the network stack
+  bool (*publishOne)();    // publish and drop the oldest record
+  void (*sleep)(uint32_t ms);
+};
+
+enum DutyPhase : uint8_t { DUTY_WARMUP, DUTY_SAMPLE, DUTY_CONNECT, DUTY_PUBLISH, DUTY_SLEEP, DUTY_DONE };
+
+class DutyCycle {
+public:
+  DutyCycle(const DutyCycleConfig &cfg, const DutyCycleHal &hal, uint32_t wakeCount)
+  : _cfg(cfg), _hal(hal), _wakeCount(wakeCount), _phase(DUTY_WARMUP), _wakeAt(hal.nowMs()), _phaseAt(_wakeAt) {
+    _hal.startWarmup();
+  }
+
+  // Advance without blocking; call until DUTY_DONE
+  DutyPhase step() {
+    uint32_t now = _hal.nowMs();
+
+    switch (_phase) {
+      case DUTY_WARMUP:
+        if (now - _phaseAt >= _cfg.warmupMs) enter(DUTY_SAMPLE, now);
+        break;
+
+      case DUTY_SAMPLE:
+        _hal.sample();
+        if (shouldPublish()) {
+          _hal.startNetwork();
+          enter(DUTY_CONNECT, now);
+        } else {
+          enter(DUTY_SLEEP, now);
+        }
+        break;
+
+      case DUTY_CONNECT:
+        if (_hal.networkReady()) enter(DUTY_PUBLISH, now);
+        else if (now - _phaseAt >= _cfg.connectTimeoutMs) enter(DUTY_SLEEP, now);  // keep the batch for next time
+        break;
+
+      case DUTY_PUBLISH:
+        if (_hal.buffered() == 0 || !_hal.publishOne()) enter(DUTY_SLEEP, now);
+        else if (now - _phaseAt >= _cfg.connectTimeoutMs) enter(DUTY_SLEEP, now);
+        break;
+
+      case DUTY_SLEEP:
+        _hal.sleep(sleepMs(now));
+        enter(DUTY_DONE, now);
+        break;
+
+      case DUTY_DONE:
+        break;
+    }
+    return _phase;
+  }
+
+  DutyPhase phase() const { return _phase; }
+
+  bool shouldPublish() const {
+    if (_cfg.publishEvery <= 1) return true;
+    if (_hal.buffered() >= _cfg.bufferCapacity) return true;
+    return _wakeCount % _cfg.publishEvery == 0;
+  }
+
+  // Keep a fixed wake period regardless of how long this wake took
+  uint32_t sleepMs(uint32_t now) const {
+    uint32_t awake = now - _wakeAt;
+    const uint32_t minSleep = 1000;
+    if (awake + minSleep >= _cfg.wakeIntervalMs) return minSleep;
+    return _cfg.wakeIntervalMs - awake;
+  }
+
+private:
+  DutyCycleConfig _cfg;
+  DutyCycleHal _hal;
+  uint32_t _wakeCount;
+  DutyPhase _phase;
+  uint32_t _wakeAt;
+  uint32_t _phaseAt;
+
+  void enter(DutyPhase p, uint32_t now) {
+    _phase = p;
+    _phaseAt = now;
+  }
+};
+
+// --- ESP32 glue (low_power.cpp) ---
+bool lowPowerWokeFromSleep();
+void runLowPowerCycle();  // never returns
@@ -1,4 +1,7 @@
 #include "mq135.h"
+#include "mq135_math.h"
+#include "adc_dma.h"
+#include "adc_kernel.h"
 #include <math.h>
 
 // ======================================================================
@@ -9,47 +12,24 @@
 #define GAS_A 70.0f
 #define GAS_B -3.2f
 
-// Approx temperature/humidity correction (from Fig4)
-static float approxCorrection(float t, float h) {
-    float kt = 1.0f + (t - 20.0f) * -0.015f;  // ~1.5% change per °C
-    float kh = 1.0f + (h - 55.0f) * -0.003f; // ~0.3% change per %RH
-    return kt * kh;
-}
-
 // ======================================================================
 // Constructor
 // ======================================================================
 MQ135::MQ135(uint8_t pin, float rload, float rzero)
-: _pin(pin), _rload(rload), _rzero(rzero) {}
+: _pin(pin), _rload(rload), _rzero(rzero), _invRzero(1.0f / rzero) {}
 
 // ======================================================================
-// ADC with noise filtering
+// ADC with noise filtering: 15 oversampled readings (DMA burst, see
+// adc_dma.h), mean of the middle 5
 // ======================================================================
-int MQ135::readADC() {
-    const int N = 15;
-    int buf[N];
-
-    for (int i = 0; i < N; i++) {
-        buf[i] = analogRead(_pin);
-        delayMicroseconds(300);
-    }
+#define MQ_READINGS 15
+#define MQ_OVERSAMPLE 16
+#define MQ_TRIM 5
 
-    // sort
-    for (int i = 0; i < N - 1; i++) {
-        for (int j = i + 1; j < N; j++) {
-            if (buf[j] < buf[i]) {
-                int t = buf[i];
-                buf[i] = buf[j];
-                buf[j] = t;
-            }
-        }
-    }
-
-    // average middle samples
-    long sum = 0;
-    for (int i = 5; i < 10; i++) sum += buf[i];
-
-    return sum / 5;
+int MQ135::readADC() {
+    uint16_t buf[MQ_READINGS];
+    if (!adcReadOversampled(_pin, buf, MQ_READINGS, MQ_OVERSAMPLE)) return 0;
+    return adcTrimmedMean(buf, MQ_READINGS, MQ_TRIM);
 }
 
 // ======================================================================
@@ -64,25 +44,23 @@ float MQ135::readRs() {
 float MQ135::readRsCorrected(float t, float h) {
     float rs = readRs();
     if (!isfinite(rs)) return NAN;
-    float cf = approxCorrection(t, h);
+    float cf = mqmath::correction(t, h);
     return rs * cf;
 }
 
 // ======================================================================
-// Generic gas index (not real ppm)
+// Generic gas index (not real ppm), power curve via mq135_math.h
 // ======================================================================
 float MQ135::getIndex() {
     float rs = readRs();
     if (!isfinite(rs)) return NAN;
-    float ratio = rs / _rzero;
-    return GAS_A * powf(ratio, GAS_B);
+    return mqmath::powerCurve(GAS_A, GAS_B, rs * _invRzero);
 }
 
 float MQ135::getCorrectedIndex(float t, float h) {
     float rs = readRsCorrected(t, h);
     if (!isfinite(rs)) return NAN;
-    float ratio = rs / _rzero;
-    return GAS_A * powf(ratio, GAS_B);
+    return mqmath::powerCurve(GAS_A, GAS_B, rs * _invRzero);
 }
 
 // ======================================================================
@@ -101,7 +79,14 @@ float MQ135::getCorrectedRZero(float t, float h) {
 }
 
 void MQ135::setRZero(float r0) {
-    if (isfinite(r0) && r0 > 0.1f) _rzero = r0;
+    if (isfinite(r0) && r0 > 0.1f) {
+        _rzero = r0;
+        _invRzero = 1.0f / r0;
+    }
+}
+
+void MQ135::setRLoad(float rload) {
+    if (isfinite(rload) && rload > 0.0f) _rload = rload;
 }
 
 float MQ135::getStoredRZero() {
@@ -128,5 +113,17 @@ float MQ135::autoCalibrate(float t, float h) {
     if (count < 30) return NAN;
 
     _rzero = sum / count;
+    _invRzero = 1.0f / _rzero;
     return _rzero;
 }
+
+// ======================================================================
+// Power curve; /api/bench compares the two
+// ======================================================================
+float MQ135::curve(float ratio) {
+    return mqmath::powerCurve(GAS_A, GAS_B, ratio);
+}
+
+float MQ135::curveReference(float ratio) {
+    return GAS_A * powf(ratio, GAS_B);
+}
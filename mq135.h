@@ -14,14 +14,20 @@ public:
     float getRZero();
     float getCorrectedRZero(float t, float h);
     void setRZero(float r0);
+    void setRLoad(float rload);
     float getStoredRZero();
 
     float autoCalibrate(float temp, float hum);
 
+    // Gas index power curve: the table version the readers use, and powf
+    static float curve(float ratio);
+    static float curveReference(float ratio);
+
 private:
     uint8_t _pin;
     float _rload;
     float _rzero;
+    float _invRzero;  // avoids a float division per read
 
     int readADC();
 };
@@ -0,0 +1,120 @@
+// mq135_math.h
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// ======================================================================
+// Table-driven log2 / exp2 for the MQ135 power curve, and the T/RH
+// correction
+//
+// A * ratio^B is evaluated as A * exp2(B * log2(ratio)). Both functions
+// split the float into exponent and mantissa and interpolate linearly in
+// a 64-segment table, so a call is a few integer ops and two multiplies.
+//
+// Error bounds (linear interpolation, h = 1/64):
+//   fastLog2: |err| <= h^2 / (8 ln2)        = 4.4e-5 (absolute, log2 units)
+//   fastExp2: |rel err| <= h^2 (ln2)^2 / 8  = 1.5e-5
+//   mqPowerCurve(ratio, -3.2): |rel err| <= 3.2 * 4.4e-5 * ln2 + 1.5e-5
+//                                         ~= 1.13e-4 vs powf
+// Float rounding of the tables and the interpolation adds under 1e-6;
+// the *_MAX_* constants below include it, and test/mq135_math_test.cpp
+// asserts them over ratios 0.01 .. 100 and the T/RH correction range.
+// The index is published rounded to an integer, so this is below one
+// count for any index under ~8000.
+//
+// Tables: LOG2[i] = log2(1 + i/64), EXP2[i] = 2^(i/64), i = 0..64
+// ======================================================================
+
+namespace mqmath {
+
+constexpr float LOG2_MAX_ERR = 4.5e-5f;       // absolute
+constexpr float EXP2_MAX_REL_ERR = 1.6e-5f;
+constexpr float CURVE_MAX_REL_ERR = 1.2e-4f;  // powerCurve with |b| <= 3.2
+
+static const float LOG2_LUT[65] = {
+    0.000000000f, 0.022367813f, 0.044394119f, 0.066089190f,
+    0.087462841f, 0.108524457f, 0.129283017f, 0.149747120f,
+    0.169925001f, 0.189824559f, 0.209453366f, 0.228818690f,
+    0.247927513f, 0.266786541f, 0.285402219f, 0.303780748f,
+    0.321928095f, 0.339850003f, 0.357552005f, 0.375039431f,
+    0.392317423f, 0.409390936f, 0.426264755f, 0.442943496f,
+    0.459431619f, 0.475733431f, 0.491853096f, 0.507794640f,
+    0.523561956f, 0.539158811f, 0.554588852f, 0.569855608f,
+    0.584962501f, 0.599912842f, 0.614709844f, 0.629356620f,
+    0.643856190f, 0.658211483f, 0.672425342f, 0.686500527f,
+    0.700439718f, 0.714245518f, 0.727920455f, 0.741466986f,
+    0.754887502f, 0.768184325f, 0.781359714f, 0.794415866f,
+    0.807354922f, 0.820178962f, 0.832890014f, 0.845490051f,
+    0.857980995f, 0.870364720f, 0.882643049f, 0.894817763f,
+    0.906890596f, 0.918863237f, 0.930737338f, 0.942514505f,
+    0.954196310f, 0.965784285f, 0.977279923f, 0.988684687f,
+    1.000000000f,
+};
+
+static const float EXP2_LUT[65] = {
+    1.000000000f, 1.010889286f, 1.021897149f, 1.033024879f,
+    1.044273782f, 1.055645178f, 1.067140401f, 1.078760798f,
+    1.090507733f, 1.102382583f, 1.114386743f, 1.126521619f,
+    1.138788635f, 1.151189230f, 1.163724859f, 1.176396992f,
+    1.189207115f, 1.202156731f, 1.215247360f, 1.228480536f,
+    1.241857812f, 1.255380757f, 1.269050957f, 1.282870016f,
+    1.296839555f, 1.310961212f, 1.325236643f, 1.339667524f,
+    1.354255547f, 1.369002423f, 1.383909882f, 1.398979673f,
+    1.414213562f, 1.429613338f, 1.445180807f, 1.460917794f,
+    1.476826146f, 1.492907728f, 1.509164428f, 1.525598151f,
+    1.542210825f, 1.559004400f, 1.575980845f, 1.593142151f,
+    1.610490332f, 1.628027422f, 1.645755478f, 1.663676580f,
+    1.681792831f, 1.700106354f, 1.718619298f, 1.737333835f,
+    1.756252160f, 1.775376493f, 1.794709075f, 1.814252176f,
+    1.834008086f, 1.853979125f, 1.874167634f, 1.894575982f,
+    1.915206561f, 1.936061793f, 1.957144124f, 1.978456026f,
+    2.000000000f,
+};
+
+// Positive normal floats only; anything else gives NAN
+inline float fastLog2(float x) {
+    if (!(x > 0.0f) || !isfinite(x)) return NAN;
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int32_t e = (int32_t)((bits >> 23) & 0xFF) - 127;
+    if (e == -127) return NAN;  // denormal
+
+    uint32_t i = (bits >> 17) & 0x3F;                    // top 6 mantissa bits
+    float t = (float)(bits & 0x1FFFF) * (1.0f / 131072.0f);  // remaining 17 bits
+    return (float)e + LOG2_LUT[i] + (LOG2_LUT[i + 1] - LOG2_LUT[i]) * t;
+}
+
+inline float fastExp2(float y) {
+    if (isnan(y)) return NAN;
+    if (y < -126.0f) return 0.0f;
+    if (y >= 128.0f) return INFINITY;
+
+    float fl = floorf(y);
+    float pos = (y - fl) * 64.0f;
+    uint32_t i = (uint32_t)pos;
+    if (i > 63) i = 63;
+    float t = pos - (float)i;
+    float m = EXP2_LUT[i] + (EXP2_LUT[i + 1] - EXP2_LUT[i]) * t;  // [1, 2]
+
+    uint32_t bits;
+    memcpy(&bits, &m, sizeof(bits));
+    bits += (uint32_t)((int32_t)fl) << 23;  // scale by 2^fl
+    memcpy(&m, &bits, sizeof(bits));
+    return m;
+}
+
+// a * ratio^b
+inline float powerCurve(float a, float b, float ratio) {
+    return a * fastExp2(b * fastLog2(ratio));
+}
+
+// Approx temperature/humidity correction of Rs (Winsen Fig4); two
+// multiply-adds, nothing to tabulate
+inline float correction(float t, float h) {
+    float kt = 1.0f + (t - 20.0f) * -0.015f;  // ~1.5% change per °C
+    float kh = 1.0f + (h - 55.0f) * -0.003f; // ~0.3% change per %RH
+    return kt * kh;
+}
+
+}  // namespace mqmath
@@ -3,11 +3,17 @@
 #include <SPIFFS.h>
 #include <WiFi.h>
 #include <PubSubClient.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
 #include "config.h"
+#include "data.h"  // mqttClient, wifiRecordPublishLatency
+#include "timebase.h"
+#include "boot_profiler.h"
+#include "file_queue.h"
+#include "heap_monitor.h"
+#include "trace.h"
+#include "low_power.h"
 
-// --- MQTT client ---
-static WiFiClient wifiClient;
-static PubSubClient mqttClient(wifiClient);
 static unsigned long lastQueueSend = 0;
 
 // --- RAM queue ---
@@ -15,86 +21,163 @@ static unsigned long lastQueueSend = 0;
 static String ramQueue[MAX_RAM_QUEUE];
 static uint8_t ramQueueCount = 0;
 
+// --- Flash queue (power-loss safe, see file_queue.h) ---
+#define LEGACY_QUEUE_FILE "/mqtt_queue.txt"
+static FileQueue fileQueue(SPIFFS, "/mq");
+static bool fileQueueReady = false;
+
+// Records per sendQueue() call. A long backlog goes out over several
+// loop() passes instead of holding one for seconds.
+#define QUEUE_DRAIN_PER_CALL 32
+static bool queueBacklog = false;  // last call stopped at the bound
+
+static bool bootReportSent = false;
+
 static unsigned long lastReconnectAttempt = 0;
 const unsigned long RECONNECT_INTERVAL = 5000; // 5s
 
+// Mounts SPIFFS and recovers the queue on first use
+static bool ensureFileQueue() {
+    if (!fileQueueReady) {
+        if (!SPIFFS.begin()) return false;
+        fileQueue.begin();
+        // Backlog written by older firmware
+        if (SPIFFS.exists(LEGACY_QUEUE_FILE) && fileQueue.adopt(LEGACY_QUEUE_FILE)) {
+            addLog("[MQTT] Adopted legacy queue file");
+        }
+        SPIFFS.remove("/tmp_queue.txt");
+        fileQueueReady = true;
+        addLogf("[MQTT] File queue ready, %u bytes pending", fileQueue.pendingBytes());
+    }
+    fileQueue.setMaxBytes(appConfig.queueMaxSize);
+    return true;
+}
+
 // --- Append JSON to RAM/File queue ---
 void appendToQueue(const String &json) {
+    HEAP_SCOPE(HEAP_QUEUE);
     if (ramQueueCount < MAX_RAM_QUEUE) {
         ramQueue[ramQueueCount++] = json;
         addLogf("[MQTT] Added to RAM queue (%d/%d)", ramQueueCount, MAX_RAM_QUEUE);
         return;
     }
 
-    // RAM đầy → kiểm tra SPIFFS trước
-    if (SPIFFS.begin()) {  // nếu SPIFFS mount thành công
-        if (!SPIFFS.exists("/mqtt_queue.txt")) {
-            File f = SPIFFS.open("/mqtt_queue.txt", "w");
-            if(f) f.close();
-        }
-
-        File f = SPIFFS.open("/mqtt_queue.txt", "a");
-        if(f) {
-            for(uint8_t i = 0; i < ramQueueCount; i++) f.println(ramQueue[i]);
-            f.println(json); // thêm record mới
-            f.close();
-            addLogf("[MQTT] RAM queue flushed to file (%d records)", ramQueueCount+1);
-            ramQueueCount = 0;
-            return;
+    // RAM đầy → chuyển cả hàng đợi RAM xuống flash
+    if (ensureFileQueue()) {
+        TRACE_SCOPE(TR_QUEUE_FLUSH);
+        uint32_t dropped = fileQueue.counters().dropped;
+        for (uint8_t i = 0; i < ramQueueCount; i++) fileQueue.append(ramQueue[i]);
+        fileQueue.append(json); // thêm record mới
+        addLogf("[MQTT] RAM queue flushed to file (%d records)", ramQueueCount + 1);
+        if (fileQueue.counters().dropped != dropped) {
+            addLogf("[MQTT] Queue over %u bytes, dropped %u oldest records", appConfig.queueMaxSize,
+                    fileQueue.counters().dropped - dropped);
         }
+        ramQueueCount = 0;
+        return;
     }
 
-    // Nếu không có SPIFFS hoặc mở file fail, chỉ giữ trong RAM
+    // Nếu không có SPIFFS, chỉ giữ trong RAM
     addLog("[MQTT] RAM full, cannot flush to file, keeping in RAM");
 }
 
 // --- Send a single JSON safely ---
 void sendMQTT(const String &json) {
+    HEAP_SCOPE(HEAP_MQTT);
     if (!mqttClient.connected()) {
         appendToQueue(json);
         return;
     }
 
-    if (!mqttClient.publish(appConfig.mqttTopic, json.c_str())) {
+    // Queued records may predate NTP sync; resolve their timestamps on the way out
+    String out = fixupTimestamp(json);
+    unsigned long t0 = micros();
+    traceBegin(TR_MQTT_PUBLISH);
+    bool ok = mqttClient.publish(appConfig.mqttTopic, out.c_str());
+    traceEnd(TR_MQTT_PUBLISH);
+    wifiRecordPublishLatency(micros() - t0);
+
+    if (!ok) {
         addLog("[MQTT] Publish failed, added to queue");
         appendToQueue(json);
     } else {
        // addLog("[MQTT] Message sent successfully");
     }
 }
-void sendQueue() {
-    if (!mqttClient.connected()) return;
-
-    // RAM queue first
-    for(uint8_t i = 0; i < ramQueueCount; i++) {
-        sendMQTT(ramQueue[i]);
-    }
-    ramQueueCount = 0;
+bool mqttConnected() {
+    return mqttClient.connected();
+}
 
-    // Kiểm tra SPIFFS trước khi xử lý file queue
-    if (!SPIFFS.begin()) return;  // nếu không mount được, bỏ qua
+bool mqttPublishNow(const String &json) {
+    if (!mqttClient.connected()) return false;
+    TRACE_SCOPE(TR_MQTT_PUBLISH);
+    String out = fixupTimestamp(json);
+    return mqttClient.publish(appConfig.mqttTopic, out.c_str());
+}
 
-    if (!SPIFFS.exists("/mqtt_queue.txt")) return;
+static bool publishQueued(const String &record) {
+    TRACE_SCOPE(TR_MQTT_PUBLISH);
+    // Queued records may predate NTP sync; resolve their timestamps on the way out
+    String out = fixupTimestamp(record);
+    return mqttClient.publish(appConfig.mqttTopic, out.c_str());
+}
 
-    File f = SPIFFS.open("/mqtt_queue.txt", "r");
-    if(!f) return;
+// Oldest first: the flash backlog predates anything still in RAM.
+// Stops at the first failed publish so order is kept for the next round,
+// or after QUEUE_DRAIN_PER_CALL records; loopMQTT() then calls again on
+// the next pass without waiting for queueFlushInterval.
+void sendQueue() {
+    queueBacklog = false;
+    if (!mqttClient.connected()) return;
+    HEAP_SCOPE(HEAP_QUEUE);
+    TRACE_SCOPE(TR_QUEUE_FLUSH);
+
+    uint32_t budget = QUEUE_DRAIN_PER_CALL;
+    if (ensureFileQueue()) {
+        budget -= fileQueue.drain(publishQueued, budget);
+        if (!fileQueue.empty()) {
+            queueBacklog = budget == 0;
+            return;
+        }
+    }
 
-    File temp = SPIFFS.open("/tmp_queue.txt", "w");
-    if(!temp) { f.close(); return; }
+    uint8_t sent = 0;
+    while (sent < ramQueueCount && sent < budget && publishQueued(ramQueue[sent])) sent++;
+    queueBacklog = sent == budget && sent < ramQueueCount;
+    if (sent == 0) return;
 
-    while(f.available()) {
-        String line = f.readStringUntil('\n');
-        line.trim();
-        if(line.length() == 0) continue;
+    for (uint8_t i = sent; i < ramQueueCount; i++) ramQueue[i - sent] = ramQueue[i];
+    for (uint8_t i = ramQueueCount - sent; i < ramQueueCount; i++) ramQueue[i] = String();
+    ramQueueCount -= sent;
+}
 
-        if (!mqttClient.publish(appConfig.mqttTopic, line.c_str())) {
-            temp.println(line); // giữ lại các dòng chưa gửi
-        }
-    }
+void queueStatsJson(JsonObject obj) {
+    obj["ram_records"] = ramQueueCount;
+    obj["file_ready"] = fileQueueReady;
+    if (!fileQueueReady) return;
+
+    const FileQueue::Counters &c = fileQueue.counters();
+    obj["pending_bytes"] = fileQueue.pendingBytes();
+    obj["max_bytes"] = appConfig.queueMaxSize;
+    obj["appends"] = c.appends;
+    obj["append_bytes"] = c.appendBytes;
+    obj["bytes_written"] = c.bytesWritten;
+    obj["cursor_writes"] = c.cursorWrites;
+    obj["compactions"] = c.compactions;
+    obj["published"] = c.published;
+    obj["dropped"] = c.dropped;
+    obj["corrupt"] = c.corrupt;
+    obj["write_amplification"] = fileQueue.writeAmplification();
+}
 
-    f.close(); temp.close();
-    SPIFFS.remove("/mqtt_queue.txt");
-    SPIFFS.rename("/tmp_queue.txt", "/mqtt_queue.txt");
+void setupQueueRoutes() {
+    server.on("/api/queue", HTTP_GET, [](AsyncWebServerRequest *request) {
+        StaticJsonDocument<512> doc;
+        queueStatsJson(doc.to<JsonObject>());
+        String json;
+        serializeJson(doc, json);
+        request->send(200, "application/json", json);
+    });
 }
 
 // --- MQTT reconnect ---
@@ -111,6 +194,15 @@ void reconnectMQTT() {
 
     if (mqttClient.connect(clientId.c_str(), appConfig.mqttUser, appConfig.mqttPass)) {
         addLog("[MQTT] Connected");
+        bootPhaseEnd(BOOT_MQTT);
+        bootSetReady(BOOT_READY_MQTT);
+
+        // First message after boot carries the startup profile; a timer
+        // wake is not a boot, its burst is data only
+        if (!bootReportSent) {
+            bootReportSent = lowPowerWokeFromSleep() || mqttClient.publish(appConfig.mqttTopic, bootProfileJson().c_str());
+        }
+
         sendQueue();
     } else {
         addLogf("[MQTT] Connection failed, rc=%d", mqttClient.state());
@@ -124,6 +216,20 @@ void setupMQTT() {
     }
 }
 
+// --- Skip the reconnect throttle: the next loopMQTT() tries at once ---
+void mqttConnectNow() {
+    lastReconnectAttempt = millis() - RECONNECT_INTERVAL;
+}
+
+// --- Apply changed broker settings without a reboot ---
+void mqttReconfigure() {
+    if (mqttClient.connected()) mqttClient.disconnect();
+    setupMQTT();
+    mqttConnectNow();
+    addLogf("[MQTT] Reconfigured: %s (%s:%u)", appConfig.mqttEnabled ? "enabled" : "disabled",
+            appConfig.mqttServer, appConfig.mqttPort);
+}
+
 // --- Loop MQTT ---
 void loopMQTT() {
     if (!appConfig.mqttEnabled) return;
@@ -131,7 +237,7 @@ void loopMQTT() {
     if (!mqttClient.connected()) reconnectMQTT();
     mqttClient.loop();
 
-    if (millis() - lastQueueSend >= appConfig.queueFlushInterval) {
+    if (queueBacklog || millis() - lastQueueSend >= appConfig.queueFlushInterval) {
         if (mqttClient.connected()) sendQueue();
         lastQueueSend = millis();
     }
@@ -2,8 +2,15 @@
 #pragma once
 #include <Arduino.h>
 #include <PubSubClient.h>
+#include <ArduinoJson.h>
 
 void setupMQTT();
 void loopMQTT();
 void appendToQueue(const String &json);
 void sendMQTT(const String &json);  // safe MQTT send
+bool mqttConnected();
+bool mqttPublishNow(const String &json);  // no queue fallback; false if not sent
+void mqttConnectNow();   // next loopMQTT() connects without waiting out the retry interval
+void mqttReconfigure();  // server/credentials/topic changed: drop the session and reconnect
+void queueStatsJson(JsonObject obj);  // RAM/flash queue depth and flash write counters
+void setupQueueRoutes();                // GET /api/queue
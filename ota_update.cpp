@@ -4,6 +4,8 @@
 #include <WiFi.h>
 #include <ArduinoOTA.h>
 #include "config.h"
+#include "loop_monitor.h"
+#include "trace.h"
 
 void setupOTA() {
   ArduinoOTA.setHostname(appConfig.deviceId);
@@ -23,6 +25,8 @@ void setupOTA() {
     char buf[50];
     sprintf(buf, "OTA Progress: %u%%", (progress / (total / 100)));
     addLog(buf);
+    traceInstant(TR_OTA_CHUNK);  // the chunk is written before this callback, untimed
+    loopMonitorFeed();  // the whole upload runs inside ArduinoOTA.handle()
   });
 
   ArduinoOTA.onError([](ota_error_t error) {
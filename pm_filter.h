@@ -0,0 +1,68 @@
+// pm_filter.h
+#pragma once
+#include <math.h>
+
+// =====================================================================
+// PM fusion: humidity growth correction + scalar Kalman filter.
+// Pure logic, no hardware access.
+// =====================================================================
+
+// Optical sensors size water-swollen particles. Single-parameter
+// kappa-Koehler growth: dry = wet / (1 + kappa * aw / (1 - aw)),
+// aw = RH / 100 capped at 0.95. kappa = 0 disables the correction.
+#define PM_RH_CAP 95.0f
+
+inline float pmHumidityCorrect(float pm, float rh, float kappa) {
+  if (!isfinite(pm) || !isfinite(rh) || kappa <= 0.0f) return pm;
+  float aw = (rh < PM_RH_CAP ? (rh > 0.0f ? rh : 0.0f) : PM_RH_CAP) / 100.0f;
+  return pm / (1.0f + kappa * aw / (1.0f - aw));
+}
+
+// Random-walk model: x' = x + w, w ~ N(0, q * dt); z = x + v, v ~ N(0, r).
+// An innovation beyond PM_KF_GATE sigma inflates the covariance by the
+// innovation itself, so real steps (smoke, cooking) are tracked within a
+// sample or two instead of being averaged away.
+#define PM_KF_MEAS_SD 8.0f  // µg/m³, per reading
+#define PM_KF_PROC_SD 1.5f  // µg/m³ per sqrt(second)
+#define PM_KF_GATE 3.0f
+
+class PmKalman {
+public:
+  void reset() { _init = false; }
+
+  float update(float z, float dtSec) {
+    if (!isfinite(z)) return value();
+    const float r = PM_KF_MEAS_SD * PM_KF_MEAS_SD;
+
+    if (!_init) {
+      _x = z;
+      _p = r;
+      _init = true;
+      return _x;
+    }
+
+    if (!(dtSec > 0.0f)) dtSec = 0.0f;
+    _p += PM_KF_PROC_SD * PM_KF_PROC_SD * dtSec;
+
+    float y = z - _x;
+    float s = _p + r;
+    if (y * y > PM_KF_GATE * PM_KF_GATE * s) {
+      _p += y * y;
+      s = _p + r;
+    }
+
+    float k = _p / s;
+    _x += k * y;
+    _p *= 1.0f - k;
+    if (_x < 0.0f) _x = 0.0f;
+    return _x;
+  }
+
+  float value() const { return _init ? _x : NAN; }
+  float sd() const { return _init ? sqrtf(_p) : NAN; }  // 1-sigma uncertainty
+
+private:
+  bool _init = false;
+  float _x = 0.0f;
+  float _p = 0.0f;
+};
@@ -0,0 +1,56 @@
+// sensor_bme280.cpp
+#include <Arduino.h>
+#include "data.h"
+#include "config.h"
+#include "sensor_drivers.h"
+
+// =====================================================================
+// Global instance
+// =====================================================================
+Bme280 bme;
+bool bmeInitialized = false;
+
+// =====================================================================
+// Init BME280
+// =====================================================================
+void initBME280() {
+  if (bmeInitialized) return;
+
+  if (!bme.begin(BME280_ADDR)) {
+    addLog("[ERROR] BME280 not found");
+    bmeInitialized = false;
+  } else {
+    bmeInitialized = true;
+    configureBME280();
+    addLogf("[INFO] BME280 initialized, forced mode, conversion %lu us", (unsigned long)bme.conversionUs());
+  }
+}
+
+void configureBME280() {
+  if (!bmeInitialized) return;
+  bme.configure(appConfig.bmeOsT, appConfig.bmeOsP, appConfig.bmeOsH, appConfig.bmeFilter);
+}
+
+// =====================================================================
+// Driver (sensor_drivers.h)
+// =====================================================================
+void Bme280Driver::init() { initBME280(); }
+bool Bme280Driver::ready() { return bmeInitialized; }
+
+// Start the forced conversion so it has finished by the sample deadline
+void Bme280Driver::schedule(unsigned long msToSample) {
+  if (msToSample * 1000UL <= bme.conversionUs()) bme.trigger();
+}
+
+void Bme280Driver::read(SensorSample& s) {
+  Bme280Reading env;
+  if (!bme.read(env)) return;
+  s.v[CH_T] = despike(s, CH_T, safeRound(env.temperature, 1));
+  s.v[CH_H] = despike(s, CH_H, safeRound(env.humidity, 1));
+  s.v[CH_P] = despike(s, CH_P, safeRound(env.pressure, 1));
+}
+
+void Bme280Driver::sysinfo(JsonObject obj) {
+  obj["bme_bus_us"] = (uint32_t)bme.busStats().average();
+  obj["bme_lat_us"] = (uint32_t)bme.latencyStats().average();
+}
@@ -0,0 +1,72 @@
+// sensor_drivers.h
+#pragma once
+#include "sensor_registry.h"
+
+// =====================================================================
+// Drivers for this board: hardware in sensor_<name>.cpp, derived ones in
+// data_sensor.cpp. To build a variant, add a driver struct and list it in
+// SensorRegistry; new quantities also need a SampleChannel entry.
+// =====================================================================
+
+// Hampel check shared by the drivers (data_sensor.cpp)
+float despike(SensorSample &s, SampleChannel ch, float x);
+
+struct Bme280Driver {
+  static const char *name() { return "bme280"; }
+  static constexpr uint16_t CHANNELS = SENSOR_CH(CH_T) | SENSOR_CH(CH_H) | SENSOR_CH(CH_P);
+  static void init();
+  static bool ready();
+  static void schedule(unsigned long msToSample);
+  static void read(SensorSample &s);
+  static int debug(char *, size_t) { return 0; }
+  static void sysinfo(JsonObject obj);  // bus and latency averages
+};
+
+// Derived: dew point, heat index, absolute humidity, sea-level pressure
+struct DerivedDriver {
+  static const char *name() { return "derived"; }
+  static constexpr uint16_t CHANNELS = SENSOR_CH(CH_DEW) | SENSOR_CH(CH_HI) | SENSOR_CH(CH_AH) | SENSOR_CH(CH_SLP);
+  static void init() {}
+  static bool ready() { return true; }
+  static void schedule(unsigned long) {}
+  static void read(SensorSample &s);  // uses CH_T, CH_H, CH_P
+  static int debug(char *, size_t) { return 0; }
+  static void sysinfo(JsonObject) {}
+};
+
+// GP2Y1014 pulse engine
+struct DustDriver {
+  static const char *name() { return "gp2y1014"; }
+  static constexpr uint16_t CHANNELS = SENSOR_CH(CH_PM) | SENSOR_CH(CH_PM_SD);
+  static void init();
+  static bool ready();
+  static void schedule(unsigned long) {}
+  static void read(SensorSample &s);  // uses CH_H
+  static int debug(char *buf, size_t len);  // raw PM before the filter
+  static void sysinfo(JsonObject obj);      // pulse and skipped counts
+};
+
+// Derived: NowCast AQI in the configured standard (aqi.h)
+struct AqiDriver {
+  static const char *name() { return "aqi"; }
+  static constexpr uint16_t CHANNELS = SENSOR_CH(CH_AQI);
+  static void init() {}
+  static bool ready() { return true; }
+  static void schedule(unsigned long) {}
+  static void read(SensorSample &s);  // uses CH_PM
+  static int debug(char *, size_t) { return 0; }
+  static void sysinfo(JsonObject) {}
+};
+
+struct Mq135Driver {
+  static const char *name() { return "mq135"; }
+  static constexpr uint16_t CHANNELS = SENSOR_CH(CH_MQ);
+  static void init();
+  static bool ready();
+  static void schedule(unsigned long) {}
+  static void read(SensorSample &s);  // uses CH_T, CH_H
+  static int debug(char *, size_t) { return 0; }
+  static void sysinfo(JsonObject) {}
+};
+
+typedef SensorList<Bme280Driver, DerivedDriver, DustDriver, AqiDriver, Mq135Driver> SensorRegistry;
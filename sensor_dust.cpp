@@ -0,0 +1,69 @@
+// sensor_dust.cpp
+#include <Arduino.h>
+#include "data.h"
+#include "config.h"
+#include "timebase.h"
+#include "pm_filter.h"
+#include "sensor_drivers.h"
+
+// =====================================================================
+// Global instance
+// =====================================================================
+DustEngine* dustSensor = nullptr;
+
+static float lastPmRaw = NAN;
+
+// =====================================================================
+// Init Dust Sensor
+// =====================================================================
+void initDustSensor() {
+  if (dustSensor) return;
+  dustSensor = new DustEngine(appConfig.dustLEDPin, appConfig.dustADCPin);
+  dustSensor->begin();
+
+  if (isfinite(appConfig.dust_baseline) && appConfig.dust_baseline > 0.0f) {
+    dustSensor->setBaseline(appConfig.dust_baseline);
+
+    addLogf("[DustSensor] Using saved baseline=%.4f", appConfig.dust_baseline);
+  } else {
+    addLog("[DustSensor] No saved baseline, will calibrate if needed");
+  }
+
+  if (isfinite(appConfig.dust_calibration) && appConfig.dust_calibration > 0.0f) {
+    dustSensor->setCalibrationFactor(appConfig.dust_calibration);
+    addLogf("[DustSensor] Using saved CalibrationFactor=%4f", appConfig.dust_calibration);
+  } else {
+    addLog("[DustSensor] No saved CalibrationFactor, will CalibrationFactor if needed");
+  }
+}
+
+// =====================================================================
+// Driver (sensor_drivers.h)
+// =====================================================================
+void DustDriver::init() { initDustSensor(); }
+bool DustDriver::ready() { return dustSensor != nullptr; }
+
+// PM: pulse mean -> humidity growth correction -> Kalman filter
+void DustDriver::read(SensorSample& s) {
+  static PmKalman pmFilter;
+  static uint64_t lastPmMono = 0;
+  uint64_t now = monoMicros();
+  float dt = lastPmMono ? (now - lastPmMono) / 1e6f : 0.0f;
+  lastPmMono = now;
+
+  lastPmRaw = despike(s, CH_PM, dustSensor->getDustDensity());
+  if (isfinite(lastPmRaw)) {
+    float pm = pmFilter.update(pmHumidityCorrect(lastPmRaw, s.v[CH_H], appConfig.pmKappa), dt);
+    s.v[CH_PM] = safeRound(pm, 0);
+    s.v[CH_PM_SD] = safeRound(pmFilter.sd(), 1);
+  }
+}
+
+int DustDriver::debug(char* buf, size_t len) {
+  return snprintf(buf, len, " pm_raw=%.0f", lastPmRaw);
+}
+
+void DustDriver::sysinfo(JsonObject obj) {
+  obj["dust_pulses"] = dustSensor->pulseCount();
+  obj["dust_skipped"] = dustSensor->skippedCount();
+}
@@ -0,0 +1,42 @@
+// sensor_mq135.cpp
+#include <Arduino.h>
+#include "data.h"
+#include "config.h"
+#include "mq135.h"
+#include "sensor_drivers.h"
+
+// =====================================================================
+// Global instance
+// =====================================================================
+MQ135* mq135 = nullptr;
+
+// =====================================================================
+// Init MQ135
+// =====================================================================
+void initMQ135() {
+  if (mq135) return;
+
+  float r0 = appConfig.mq_rzero;
+
+  if (!isfinite(r0) || r0 <= 0.0f || r0 > 10000.0f) {
+    addLog("[MQ135] Invalid RZERO, using default (80.0)");
+    r0 = 80.0f;
+  } else {
+    addLogf("[MQ135] Loaded saved RZERO=%.3f", r0);
+  }
+
+  mq135 = new MQ135(appConfig.mqADCPin,
+                    appConfig.mq_rl_kohm,
+                    r0);
+}
+
+// =====================================================================
+// Driver (sensor_drivers.h)
+// =====================================================================
+void Mq135Driver::init() { initMQ135(); }
+bool Mq135Driver::ready() { return mq135 != nullptr; }
+
+void Mq135Driver::read(SensorSample& s) {
+  if (!isfinite(s.v[CH_T]) || !isfinite(s.v[CH_H])) return;
+  s.v[CH_MQ] = despike(s, CH_MQ, safeRound(mq135->getCorrectedIndex(s.v[CH_T], s.v[CH_H]), 0));
+}
@@ -0,0 +1,88 @@
+// sensor_registry.h
+#pragma once
+#include <ArduinoJson.h>
+#include <stdint.h>
+
+#include "data.h"
+
+// =====================================================================
+// Compile-time sensor registry.
+// A driver is a struct of static members:
+//   static const char *name();
+//   static constexpr uint16_t CHANNELS;  // bit per SampleChannel it fills
+//   static void init();                  // probe and start the hardware
+//   static bool ready();
+//   static void schedule(unsigned long msToSample);  // start conversions due before the sample
+//   static void read(SensorSample &s);   // fill CHANNELS
+//   static int debug(char *buf, size_t len);  // extra fields for the sample log line
+//   static void sysinfo(JsonObject obj);  // driver counters for the sysinfo broadcast
+// SensorList<A, B, ...> expands into direct calls, so there are no vtables.
+// A hardware driver owns its device object in its own unit (sensor_*.cpp);
+// a driver left out of the list is never initialised or read, and the
+// linker drops its unit unless other code (calibrate.cpp) still uses the
+// object. Drivers are read in list order: later ones may use channels
+// filled by earlier ones.
+// =====================================================================
+
+#define SENSOR_CH(ch) (1u << (ch))
+
+// One registry entry for /api/sensors (data_sensor.cpp)
+void describeSensor(JsonArray out, const char *name, bool ready, uint16_t channels);
+
+template <typename... Drivers>
+struct SensorList;
+
+template <>
+struct SensorList<> {
+  static constexpr uint16_t CHANNELS = 0;
+  static constexpr uint8_t SIZE = 0;
+
+  static void init() {}
+  static void schedule(unsigned long) {}
+  static void read(SensorSample &) {}
+  static int debug(char *, size_t) { return 0; }
+  static void sysinfo(JsonObject) {}
+  static void describe(JsonArray) {}
+};
+
+template <typename Head, typename... Tail>
+struct SensorList<Head, Tail...> {
+  typedef SensorList<Tail...> Next;
+
+  static constexpr uint16_t CHANNELS = Head::CHANNELS | Next::CHANNELS;
+  static constexpr uint8_t SIZE = 1 + Next::SIZE;
+  static_assert((Head::CHANNELS & Next::CHANNELS) == 0, "two sensor drivers fill the same channel");
+  static_assert(CHANNELS < (1 << CH_COUNT), "sensor driver fills an unknown channel");
+
+  static void init() {
+    Head::init();
+    Next::init();
+  }
+
+  static void schedule(unsigned long msToSample) {
+    if (Head::ready()) Head::schedule(msToSample);
+    Next::schedule(msToSample);
+  }
+
+  static void read(SensorSample &s) {
+    if (Head::ready()) Head::read(s);
+    Next::read(s);
+  }
+
+  // Returns the length written, snprintf-style
+  static int debug(char *buf, size_t len) {
+    int n = Head::ready() ? Head::debug(buf, len) : 0;
+    if (n < 0 || (size_t)n >= len) return n;
+    return n + Next::debug(buf + n, len - n);
+  }
+
+  static void sysinfo(JsonObject obj) {
+    if (Head::ready()) Head::sysinfo(obj);
+    Next::sysinfo(obj);
+  }
+
+  static void describe(JsonArray out) {
+    describeSensor(out, Head::name(), Head::ready(), Head::CHANNELS);
+    Next::describe(out);
+  }
+};
@@ -59,12 +59,22 @@ h3{color:#34495e;margin-top:20px;padding-bottom:5px;border-bottom:1px dashed #cc
 <div class="form-row"><label for="mqttPass">MQTT Password:</label><input type="password" id="mqttPass" name="mqttPass"></div>
 <div class="form-row"><label for="mqttTopic">MQTT Topic:</label><input type="text" id="mqttTopic" name="mqttTopic"></div>
 <div class="form-row"><label for="sendInterval">Send Interval (ms):</label><input type="number" id="sendInterval" name="sendInterval"></div>
+<div class="form-row"><label for="publishWindow">Publish Window (s, 0 = every sample):</label><input type="number" id="publishWindow" name="publishWindow"></div>
 
 <h3>Queue Settings</h3>
 <div class="form-row"><label for="queueMaxSize">Queue Max Size (bytes):</label><input type="number" id="queueMaxSize" name="queueMaxSize"></div>
 <div class="form-row"><label for="queueFlushInterval">Queue Flush Interval (ms):</label><input type="number" id="queueFlushInterval" name="queueFlushInterval"></div>
 
 
+<h3>Low Power</h3>
+<div class="form-row">
+  <label for="lowPowerMode">Deep-sleep duty cycle:</label>
+  <input type="checkbox" id="lowPowerMode" name="lowPowerMode">
+</div>
+<div class="form-row"><label for="wakeInterval">Wake Interval (s):</label><input type="number" id="wakeInterval" name="wakeInterval"></div>
+<div class="form-row"><label for="publishEveryN">Publish every N wakes:</label><input type="number" id="publishEveryN" name="publishEveryN"></div>
+<div class="form-row"><label for="sensorWarmupMs">Sensor warm-up (ms):</label><input type="number" id="sensorWarmupMs" name="sensorWarmupMs"></div>
+
 <h3>Sensor Pinout & Calibration</h3>
 <div class="form-row">
   <label for="autoCalibrateOnBoot">Auto Calibrate on Boot:</label>
@@ -79,9 +89,56 @@ h3{color:#34495e;margin-top:20px;padding-bottom:5px;border-bottom:1px dashed #cc
 <div class="form-row"><label for="mq_rzero">MQ RZERO:</label><input type="number" step="0.01" id="mq_rzero" name="mq_rzero"></div>
 <div class="form-row"><label for="dust_baseline">Dust Baseline:</label><input type="number" step="0.0001" id="dust_baseline" name="dust_baseline"></div>
 <div class="form-row"><label for="dust_calibration">Dust calibration factor:</label><input type="number" step="0.0001" id="dust_calibration" name="dust_calibration"></div>
+<div class="form-row"><label for="pmKappa">PM humidity kappa (0 = off):</label><input type="number" step="0.01" id="pmKappa" name="pmKappa"></div>
+<div class="form-row">
+  <label for="bmeOsT">BME280 oversampling T / P / H:</label>
+  <select id="bmeOsT" name="bmeOsT"><option value="1">x1</option><option value="2">x2</option><option value="3">x4</option><option value="4">x8</option><option value="5">x16</option></select>
+  <select id="bmeOsP" name="bmeOsP"><option value="0">off</option><option value="1">x1</option><option value="2">x2</option><option value="3">x4</option><option value="4">x8</option><option value="5">x16</option></select>
+  <select id="bmeOsH" name="bmeOsH"><option value="0">off</option><option value="1">x1</option><option value="2">x2</option><option value="3">x4</option><option value="4">x8</option><option value="5">x16</option></select>
+</div>
+<div class="form-row">
+  <label for="bmeFilter">BME280 IIR filter:</label>
+  <select id="bmeFilter" name="bmeFilter"><option value="0">Off</option><option value="1">2</option><option value="2">4</option><option value="3">8</option><option value="4">16</option></select>
+</div>
+<div class="form-row">
+  <label for="aqiStandard">AQI standard:</label>
+  <select id="aqiStandard" name="aqiStandard">
+    <option value="0">US EPA</option>
+    <option value="1">Vietnam (VN_AQI)</option>
+    <option value="2">China (HJ 633)</option>
+  </select>
+</div>
+<div class="form-row"><label for="derivedMask">Derived fields (1 dew, 2 heat idx, 4 abs hum, 8 sea-level):</label><input type="number" id="derivedMask" name="derivedMask"></div>
+<div class="form-row"><label for="altitude">Altitude (m):</label><input type="number" step="1" id="altitude" name="altitude"></div>
+<div class="form-row">
+  <label for="spikePolicy">Spike handling:</label>
+  <select id="spikePolicy" name="spikePolicy">
+    <option value="0">Off</option>
+    <option value="1">Flag only</option>
+    <option value="2">Replace with median</option>
+    <option value="3">Drop value</option>
+  </select>
+</div>
+<div class="form-row"><label for="calTolerance">Calibration tolerance (fraction of R0):</label><input type="number" step="0.001" id="calTolerance" name="calTolerance"></div>
+<div class="form-row"><label for="calTimeout">Calibration timeout (s):</label><input type="number" id="calTimeout" name="calTimeout"></div>
+
+<h3>Logging</h3>
+<div class="form-row">
+  <label for="logLevel">Log Level:</label>
+  <select id="logLevel" name="logLevel">
+    <option value="0">Error</option>
+    <option value="1">Warning</option>
+    <option value="2">Info</option>
+    <option value="3">Debug</option>
+  </select>
+</div>
+<div class="form-row">
+  <label for="heapTrack">Heap tracking per subsystem:</label>
+  <input type="checkbox" id="heapTrack" name="heapTrack">
+</div>
 
 <div class="btn-group">
-<button type="submit" class="btn-primary">Save & Reboot</button>
+<button type="submit" class="btn-primary">Save</button>
 
 <button class="btn-warning" onclick="if(confirm('Are you sure you want to reboot the device?')) window.location.href='/reboot'">Reboot</button>
 <button class="btn-warning" onclick="if(confirm('WARNING: This will erase ALL configuration and restart. Continue?')) window.location.href='/reset'">Factory Reset</button>
@@ -117,7 +174,7 @@ document.getElementById('configForm').onsubmit = function(e){
 
         if (input.type === 'checkbox') {
             data[input.name] = input.checked; 
-        } else if (input.type === 'number') {
+        } else if (input.type === 'number' || input.tagName === 'SELECT') {
             data[input.name] = parseFloat(input.value);
         } else if (input.type === 'password') {
             if(input.value !== '') data[input.name] = input.value; 
@@ -131,7 +188,17 @@ document.getElementById('configForm').onsubmit = function(e){
         headers:{'Content-Type':'application/json'},
         body:JSON.stringify(data)
     })
-    .then(r=>r.text()).then(t=>alert(t));
+    .then(r=>r.text()).then(t=>{
+        // Applied live unless a pin/hostname change forced a reboot
+        try {
+            const res = JSON.parse(t);
+            let msg = res.message;
+            if (res.changed && res.changed.length) msg += '\nChanged: ' + res.changed.join(', ');
+            alert(msg);
+        } catch (err) {
+            alert(t);
+        }
+    });
 };
 
 </script>
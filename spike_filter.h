@@ -0,0 +1,86 @@
+// spike_filter.h
+#pragma once
+#include <math.h>
+#include <stdint.h>
+
+// =====================================================================
+// Causal Hampel filter over the last W samples.
+// A sorted copy of the window is kept next to the ring, so each update
+// is one delete + one insert (O(W)); the median is read directly and the
+// MAD is the middle of the deviations, found by walking outwards from
+// the median in the sorted window (also O(W)). W is a small constant.
+// =====================================================================
+template <uint8_t W>
+class HampelFilter {
+public:
+  static_assert(W >= 3 && (W & 1), "Hampel window must be odd and >= 3");
+
+  // x is an outlier if |x - median| > k * 1.4826 * max(MAD, floor).
+  // The floor (about one noise sigma) keeps flat signals from flagging
+  // every quantisation step.
+  HampelFilter(float k = 3.0f, float floor = 0.0f) : _k(k), _floor(floor) {}
+
+  void setFloor(float floor) { _floor = floor; }
+
+  void reset() { _fill = 0; _head = 0; }
+
+  // Returns true if x is a spike; median receives the window median
+  // (including x), the usual replacement value
+  bool check(float x, float &median) {
+    push(x);
+    median = x;
+    if (_fill < W) return false;  // not enough history yet
+
+    median = _sorted[W / 2];
+    float mad = madAround(median);
+    if (mad < _floor) mad = _floor;
+    return fabsf(x - median) > _k * 1.4826f * mad;
+  }
+
+private:
+  float _k;
+  float _floor;
+  float _ring[W];
+  float _sorted[W];
+  uint8_t _fill = 0;
+  uint8_t _head = 0;
+
+  void push(float x) {
+    if (_fill == W) {
+      // drop the oldest value from the sorted copy
+      float old = _ring[_head];
+      uint8_t i = 0;
+      while (i < _fill - 1 && _sorted[i] != old) i++;
+      for (; i < _fill - 1; i++) _sorted[i] = _sorted[i + 1];
+      _fill--;
+    }
+    _ring[_head] = x;
+    _head = (_head + 1) % W;
+
+    uint8_t j = _fill;
+    while (j > 0 && _sorted[j - 1] > x) {
+      _sorted[j] = _sorted[j - 1];
+      j--;
+    }
+    _sorted[j] = x;
+    _fill++;
+  }
+
+  // Median of |sorted[i] - med|: merge the two sides outwards from the middle
+  float madAround(float med) const {
+    int lo = W / 2 - 1, hi = W / 2 + 1;
+    float dev = 0.0f;  // the middle element itself has deviation 0
+    for (uint8_t taken = 1; taken <= W / 2; taken++) {
+      float dl = lo >= 0 ? med - _sorted[lo] : INFINITY;
+      float dh = hi < W ? _sorted[hi] - med : INFINITY;
+      if (dl <= dh) {
+        dev = dl;
+        lo--;
+      } else {
+        dev = dh;
+        hi++;
+      }
+    }
+    return dev;
+  }
+};
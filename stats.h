@@ -0,0 +1,284 @@
+// stats.h
+#pragma once
+#include <math.h>
+#include <stdint.h>
+
+// =====================================================================
+// Welford running mean / variance with min / max
+// =====================================================================
+struct RunningStats {
+  uint32_t n = 0;
+  float mean = 0.0f;
+  float m2 = 0.0f;
+  float min = NAN;
+  float max = NAN;
+
+  void reset() {
+    n = 0;
+    mean = 0.0f;
+    m2 = 0.0f;
+    min = NAN;
+    max = NAN;
+  }
+
+  void add(float x) {
+    if (!isfinite(x)) return;
+    n++;
+    float d = x - mean;
+    mean += d / n;
+    m2 += d * (x - mean);
+    if (n == 1 || x < min) min = x;
+    if (n == 1 || x > max) max = x;
+  }
+
+  float average() const { return n > 0 ? mean : NAN; }
+  float variance() const { return n > 1 ? m2 / (n - 1) : NAN; }
+  float stddev() const { return n > 1 ? sqrtf(m2 / (n - 1)) : NAN; }
+};
+
+// =====================================================================
+// P² streaming quantile estimator (Jain & Chlamtac), O(1) memory
+// =====================================================================
+class P2Quantile {
+public:
+  explicit P2Quantile(float p = 0.5f) : _p(p) { reset(); }
+
+  void reset() { _count = 0; }
+
+  void add(float x) {
+    if (!isfinite(x)) return;
+
+    // Fill the five markers first
+    if (_count < 5) {
+      _q[_count++] = x;
+      if (_count == 5) {
+        sortSmall(_q, 5);
+        for (int i = 0; i < 5; i++) _n[i] = i;
+        _np[0] = 0.0f;       _dn[0] = 0.0f;
+        _np[1] = 2.0f * _p;  _dn[1] = _p / 2.0f;
+        _np[2] = 4.0f * _p;  _dn[2] = _p;
+        _np[3] = 2.0f + 2.0f * _p; _dn[3] = (1.0f + _p) / 2.0f;
+        _np[4] = 4.0f;       _dn[4] = 1.0f;
+      }
+      return;
+    }
+    _count++;
+
+    // Locate cell k such that q[k] <= x < q[k+1]
+    int k;
+    if (x < _q[0]) {
+      _q[0] = x;
+      k = 0;
+    } else if (x >= _q[4]) {
+      _q[4] = x;
+      k = 3;
+    } else {
+      k = 0;
+      while (k < 3 && x >= _q[k + 1]) k++;
+    }
+
+    for (int i = k + 1; i < 5; i++) _n[i]++;
+    for (int i = 0; i < 5; i++) _np[i] += _dn[i];
+
+    // Adjust middle markers
+    for (int i = 1; i <= 3; i++) {
+      float d = _np[i] - _n[i];
+      if ((d >= 1.0f && _n[i + 1] - _n[i] > 1) || (d <= -1.0f && _n[i - 1] - _n[i] < -1)) {
+        int s = d >= 0.0f ? 1 : -1;
+        float qp = parabolic(i, s);
+        if (_q[i - 1] < qp && qp < _q[i + 1]) _q[i] = qp;
+        else _q[i] = _q[i] + s * (_q[i + s] - _q[i]) / (_n[i + s] - _n[i]);
+        _n[i] += s;
+      }
+    }
+  }
+
+  float value() const {
+    if (_count == 0) return NAN;
+    if (_count >= 5) return _q[2];
+
+    // Not enough samples for markers: exact quantile of what we have
+    float tmp[5];
+    for (uint32_t i = 0; i < _count; i++) tmp[i] = _q[i];
+    sortSmall(tmp, _count);
+    return tmp[(int)roundf(_p * (_count - 1))];
+  }
+
+  uint32_t count() const { return _count; }
+
+private:
+  float _p;
+  uint32_t _count;
+  float _q[5];
+  int32_t _n[5];
+  float _np[5];
+  float _dn[5];
+
+  float parabolic(int i, int d) const {
+    return _q[i] + (float)d / (_n[i + 1] - _n[i - 1]) *
+                     ((_n[i] - _n[i - 1] + d) * (_q[i + 1] - _q[i]) / (_n[i + 1] - _n[i]) +
+                      (_n[i + 1] - _n[i] - d) * (_q[i] - _q[i - 1]) / (_n[i] - _n[i - 1]));
+  }
+
+  static void sortSmall(float *a, uint32_t n) {
+    for (uint32_t i = 1; i < n; i++) {
+      float v = a[i];
+      int j = i - 1;
+      while (j >= 0 && a[j] > v) {
+        a[j + 1] = a[j];
+        j--;
+      }
+      a[j + 1] = v;
+    }
+  }
+};
+
+// =====================================================================
+// HDR-style log-linear histogram for latencies (µs)
+// 4 sub-buckets per power of two: any value is recorded within 25%.
+// Values from 2^23 µs (~8 s) up land in the last bucket; max stays exact.
+// =====================================================================
+class LatencyHistogram {
+public:
+  static const uint8_t SUB_BITS = 2;
+  static const uint8_t SUB_COUNT = 1 << SUB_BITS;
+  static const uint8_t MAX_MSB = 22;
+  static const uint8_t BUCKETS = ((MAX_MSB - SUB_BITS + 1) << SUB_BITS) + SUB_COUNT;
+
+  void reset() {
+    for (uint8_t i = 0; i < BUCKETS; i++) _counts[i] = 0;
+    _n = 0;
+    _sum = 0;
+    _max = 0;
+  }
+
+  void add(uint32_t us) {
+    _counts[bucketOf(us)]++;
+    _n++;
+    _sum += us;
+    if (us > _max) _max = us;
+  }
+
+  uint32_t count() const { return _n; }
+  uint32_t max() const { return _max; }
+  uint32_t mean() const { return _n ? (uint32_t)(_sum / _n) : 0; }
+
+  // Upper edge of the bucket holding quantile q (0..1), capped at max
+  uint32_t percentile(float q) const {
+    if (_n == 0) return 0;
+    uint32_t rank = (uint32_t)ceilf(q * _n);
+    if (rank < 1) rank = 1;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < BUCKETS; i++) {
+      seen += _counts[i];
+      if (seen >= rank) {
+        uint32_t hi = bucketUpper(i);
+        return hi < _max ? hi : _max;
+      }
+    }
+    return _max;
+  }
+
+  static uint8_t bucketOf(uint32_t v) {
+    if (v < SUB_COUNT) return v;
+    uint8_t msb = 31 - __builtin_clz(v);
+    if (msb > MAX_MSB) return BUCKETS - 1;
+    return ((msb - SUB_BITS + 1) << SUB_BITS) + ((v >> (msb - SUB_BITS)) & (SUB_COUNT - 1));
+  }
+
+  static uint32_t bucketUpper(uint8_t i) {
+    if (i < SUB_COUNT) return i;
+    uint8_t major = i >> SUB_BITS;
+    uint32_t sub = i & (SUB_COUNT - 1);
+    uint32_t width = 1UL << (major - 1);
+    return (SUB_COUNT + sub) * width + width - 1;
+  }
+
+private:
+  uint32_t _counts[BUCKETS] = {};
+  uint32_t _n = 0;
+  uint64_t _sum = 0;
+  uint32_t _max = 0;
+};
+
+// =====================================================================
+// Welford statistics behind a median/MAD outlier gate.
+// The last N inputs (accepted or not) form the reference window, so a
+// genuine level shift is accepted once it fills half the window. The
+// first MIN_WINDOW inputs only prime the window and are not counted.
+// =====================================================================
+template <uint8_t N>
+class MadGatedStats {
+public:
+  static const uint8_t MIN_WINDOW = 8;
+
+  explicit MadGatedStats(float k = 3.5f) : _k(k) {}
+
+  RunningStats stats;
+  uint32_t rejected = 0;
+
+  void reset() {
+    stats.reset();
+    rejected = 0;
+    _fill = 0;
+    _head = 0;
+  }
+
+  // Returns true if x went into stats
+  bool add(float x) {
+    if (!isfinite(x)) {
+      rejected++;
+      return false;
+    }
+
+    bool priming = _fill < MIN_WINDOW;
+    bool ok = !priming;
+    if (ok) {
+      float med, mad;
+      medianMad(med, mad);
+      if (mad > 0.0f && fabsf(x - med) > _k * 1.4826f * mad) ok = false;
+    }
+
+    _window[_head] = x;
+    _head = (_head + 1) % N;
+    if (_fill < N) _fill++;
+
+    if (ok) stats.add(x);
+    else if (!priming) rejected++;
+    return ok;
+  }
+
+  bool primed() const { return _fill >= MIN_WINDOW; }
+
+  // Half-width of the z-sigma confidence interval of the mean
+  float ciHalfWidth(float z = 1.96f) const {
+    return stats.n > 1 ? z * stats.stddev() / sqrtf((float)stats.n) : INFINITY;
+  }
+
+private:
+  float _k;
+  float _window[N];
+  uint8_t _fill = 0;
+  uint8_t _head = 0;
+
+  static float medianOf(float *a, uint8_t n) {
+    for (uint8_t i = 1; i < n; i++) {
+      float v = a[i];
+      int j = i - 1;
+      while (j >= 0 && a[j] > v) {
+        a[j + 1] = a[j];
+        j--;
+      }
+      a[j + 1] = v;
+    }
+    return n & 1 ? a[n / 2] : 0.5f * (a[n / 2 - 1] + a[n / 2]);
+  }
+
+  void medianMad(float &med, float &mad) const {
+    float tmp[N];
+    for (uint8_t i = 0; i < _fill; i++) tmp[i] = _window[i];
+    med = medianOf(tmp, _fill);
+    for (uint8_t i = 0; i < _fill; i++) tmp[i] = fabsf(_window[i] - med);
+    mad = medianOf(tmp, _fill);
+  }
+};
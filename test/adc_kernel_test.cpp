@@ -0,0 +1,102 @@
+// test/adc_kernel_test.cpp
+// Replays a TYPE1 DMA trace (data/*.hex) through adc_kernel.h the way
+// adc_dma.cpp and MQ135::readADC use it: frames parsed per channel into a
+// burst, boxcar-decimated, then a trimmed mean. Each stage is checked
+// against a plain reference computation. Run with `make -C test`.
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "adc_kernel.h"
+
+#define TRACE_FILE "data/adc_type1_mq135.hex"
+#define TRACE_CHANNEL 6      // GPIO34
+#define FRAME_BYTES 256      // ADC_DMA_FRAME_BYTES
+#define READINGS 15          // MQ_READINGS
+#define OVERSAMPLE 16        // MQ_OVERSAMPLE
+#define TRIM 5               // MQ_TRIM
+
+static int failures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                                     \
+    }                                                                 \
+  } while (0)
+
+static std::vector<uint8_t> loadHex(const char *path) {
+  std::vector<uint8_t> bytes;
+  FILE *f = fopen(path, "r");
+  if (!f) return bytes;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#') continue;
+    unsigned v;
+    int used;
+    for (const char *p = line; sscanf(p, "%2x%n", &v, &used) == 1; p += used) bytes.push_back((uint8_t)v);
+  }
+  fclose(f);
+  return bytes;
+}
+
+int main(int argc, char **argv) {
+  const char *path = argc > 1 ? argv[1] : TRACE_FILE;
+  std::vector<uint8_t> trace = loadHex(path);
+  if (trace.size() < FRAME_BYTES) {
+    printf("cannot read trace %s\n", path);
+    return 1;
+  }
+
+  // Reference: every word of the channel, in order
+  std::vector<uint16_t> ref;
+  for (size_t i = 0; i + 1 < trace.size(); i += 2) {
+    uint16_t w = trace[i] | (trace[i + 1] << 8);
+    if ((w >> 12) == TRACE_CHANNEL) ref.push_back(w & 0x0FFF);
+  }
+
+  // Burst as dmaCapture() assembles it, one frame per read
+  const size_t want = READINGS * OVERSAMPLE;
+  uint16_t raw[READINGS * OVERSAMPLE];
+  size_t got = 0;
+  for (size_t off = 0; off < trace.size() && got < want; off += FRAME_BYTES) {
+    size_t len = trace.size() - off < FRAME_BYTES ? trace.size() - off : FRAME_BYTES;
+    got += adcParseFrames(trace.data() + off, len, TRACE_CHANNEL, raw + got, want - got);
+  }
+  CHECK(got == want);
+  bool same = true;
+  for (size_t i = 0; i < got; i++) same = same && raw[i] == ref[i];
+  CHECK(same);
+
+  // A torn trailing byte and other channels are ignored
+  uint16_t one[4];
+  const uint8_t odd[] = { 0x10, 0x67, 0x2c, 0x71, 0x20 };  // ch6 0x710, ch7, half a word
+  CHECK(adcParseFrames(odd, sizeof(odd), TRACE_CHANNEL, one, 4) == 1 && one[0] == 0x710);
+
+  // Decimation: rounded block means, in place as adcReadOversampled allows
+  uint16_t dec[READINGS * OVERSAMPLE];
+  for (size_t i = 0; i < want; i++) dec[i] = raw[i];
+  CHECK(adcDecimate(dec, want, OVERSAMPLE, dec) == READINGS);
+  for (size_t b = 0; b < READINGS; b++) {
+    double sum = 0;
+    for (size_t k = 0; k < OVERSAMPLE; k++) sum += raw[b * OVERSAMPLE + k];
+    CHECK(dec[b] == (uint16_t)floor(sum / OVERSAMPLE + 0.5));
+  }
+  CHECK(adcDecimate(raw, OVERSAMPLE * 2 + 5, OVERSAMPLE, dec + READINGS) == 2);  // partial block dropped
+
+  // Trimmed mean: the glitched block is discarded, result stays on the signal
+  double clean = 0;
+  size_t cleanN = 0;
+  for (size_t i = 0; i < want; i++) {
+    if (raw[i] < 4000) clean += raw[i], cleanN++;
+  }
+  clean /= cleanN;
+  uint16_t reading = adcTrimmedMean(dec, READINGS, TRIM);
+  printf("trace %zu bytes, %zu ch%u conversions, burst mean %.1f, reading %u\n", trace.size(), ref.size(),
+         TRACE_CHANNEL, clean, reading);
+  CHECK(fabs(reading - clean) <= 2.0);
+
+  printf("adc_kernel %s (%d failures)\n", failures ? "FAILED" : "ok", failures);
+  return failures ? 1 : 0;
+}
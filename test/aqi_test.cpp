@@ -0,0 +1,198 @@
+// test/aqi_test.cpp
+// Checks aqi.h: the NowCast bucket ring against a brute-force NowCast that
+// keeps every sample and averages the last 12 hours on each evaluation,
+// over a two-day trace with gaps, invalid readings and a restart; then the
+// breakpoint tables at their band edges. Ends with a microbenchmark of
+// NowCast::add and NowCast::value. Run with `make -C test`.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "aqi.h"
+
+#define SAMPLE_S 5  // send_iv default
+#define SAMPLES_PER_HOUR (3600 / SAMPLE_S)
+#define TRACE_HOURS 48
+#define CHECK_EVERY 60  // brute force is O(samples), so not after every one
+#define BENCH_ITERS 2000000
+
+static int failures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                                     \
+    }                                                                 \
+  } while (0)
+
+struct Sample {
+  uint32_t hour;
+  float c;
+};
+
+// EPA NowCast straight from the definition, in double
+static double bruteNowCast(const std::vector<Sample> &all, uint32_t now) {
+  double sum[AQI_NOWCAST_HOURS] = {};
+  int n[AQI_NOWCAST_HOURS] = {};
+  for (const Sample &s : all) {
+    if (s.hour > now || now - s.hour >= AQI_NOWCAST_HOURS) continue;
+    if (!std::isfinite(s.c) || s.c < 0.0f) continue;
+    sum[now - s.hour] += s.c;
+    n[now - s.hour]++;
+  }
+  if ((n[0] > 0) + (n[1] > 0) + (n[2] > 0) < 2) return NAN;
+
+  double lo = INFINITY, hi = 0.0;
+  for (int i = 0; i < AQI_NOWCAST_HOURS; i++) {
+    if (!n[i]) continue;
+    lo = fmin(lo, sum[i] / n[i]);
+    hi = fmax(hi, sum[i] / n[i]);
+  }
+  double w = hi > 0.0 ? fmax(lo / hi, AQI_NOWCAST_MIN_WEIGHT) : 1.0;
+  double num = 0.0, den = 0.0;
+  for (int i = 0; i < AQI_NOWCAST_HOURS; i++) {
+    if (!n[i]) continue;
+    num += pow(w, i) * sum[i] / n[i];
+    den += pow(w, i);
+  }
+  return num / den;
+}
+
+static bool matches(float got, double want) {
+  if (std::isnan(want)) return std::isnan(got);
+  return fabs(got - want) <= 1e-4 * want + 1e-3;
+}
+
+// Hourly level that swings between clean and smoky, plus noise
+static float level(uint32_t hour, int i) {
+  float base = 15.0f + 60.0f * (hour % 9 < 3) + 8.0f * sinf(hour * 0.7f);
+  return base + (float)(rand() % 2001 - 1000) / 100.0f + (i % 7) * 0.1f;
+}
+
+static void testAgainstBruteForce() {
+  srand(45);
+  NowCast nc;
+  nc.reset();
+  std::vector<Sample> all;
+  int checked = 0, mismatched = 0;
+
+  for (uint32_t hour = 100; hour < 100 + TRACE_HOURS; hour++) {
+    if (hour % 17 == 5) continue;                  // sensor off for an hour
+    if (hour == 130) hour += AQI_NOWCAST_HOURS;    // long outage: history expires
+    for (int i = 0; i < SAMPLES_PER_HOUR; i++) {
+      if (hour % 11 == 3 && i > SAMPLES_PER_HOUR / 4) break;  // partial hour
+      float c = i % 97 == 13 ? NAN : level(hour, i);          // dropped readings
+      if (i % 211 == 7) c = -1.0f;
+      nc.add(hour, c);
+      all.push_back({ hour, c });
+      if (i % CHECK_EVERY == 0) {
+        double want = bruteNowCast(all, hour);
+        float got = nc.value();
+        checked++;
+        if (!matches(got, want)) {
+          if (mismatched++ < 5) printf("hour %u sample %d: ring %.4f brute %.4f\n", hour, i, got, want);
+        }
+      }
+    }
+  }
+  printf("nowcast: %d evaluations against brute force, %d mismatched\n", checked, mismatched);
+  CHECK(checked > 0);
+  CHECK(mismatched == 0);
+
+  // Clock restart: the ring starts over from the new samples
+  nc.add(5, 40.0f);
+  CHECK(std::isnan(nc.value()));  // one recent hour is not enough
+  nc.add(6, 20.0f);
+  // w = 0.5: (20 + 0.5 * 40) / 1.5
+  CHECK(matches(nc.value(), 40.0 / 1.5));
+}
+
+static void testNowCastCases() {
+  NowCast nc;
+  nc.reset();
+  CHECK(std::isnan(nc.value()));
+  for (uint32_t h = 0; h < AQI_NOWCAST_HOURS; h++) nc.add(h, 10.0f);
+  CHECK(matches(nc.value(), 10.0));  // steady level: NowCast equals it
+
+  // Zero-initialised state is empty (RTC memory across deep sleep)
+  NowCast zero = {};
+  CHECK(std::isnan(zero.value()));
+  zero.add(0, 12.0f);
+  zero.add(1, 12.0f);
+  CHECK(matches(zero.value(), 12.0));
+
+  // Only the current hour among the last three: not valid
+  NowCast sparse = {};
+  sparse.add(10, 30.0f);
+  sparse.add(13, 30.0f);
+  CHECK(std::isnan(sparse.value()));
+}
+
+static void testBreakpoints() {
+  CHECK(aqiSubIndex(AQI_US_EPA, AQI_PM25, 0.0f) == 0);
+  CHECK(aqiSubIndex(AQI_US_EPA, AQI_PM25, 12.0f) == 50);
+  CHECK(aqiSubIndex(AQI_US_EPA, AQI_PM25, 12.05f) == 50);  // truncated to 12.0
+  CHECK(aqiSubIndex(AQI_US_EPA, AQI_PM25, 12.1f) == 51);
+  CHECK(aqiSubIndex(AQI_US_EPA, AQI_PM25, 35.4f) == 100);
+  CHECK(aqiSubIndex(AQI_US_EPA, AQI_PM25, 35.5f) == 101);
+  CHECK(aqiSubIndex(AQI_US_EPA, AQI_PM25, 500.4f) == 500);
+  CHECK(aqiSubIndex(AQI_US_EPA, AQI_PM25, 900.0f) == 500);  // capped
+  CHECK(aqiSubIndex(AQI_US_EPA, AQI_PM10, 154.0f) == 100);
+  CHECK(aqiSubIndex(AQI_VN, AQI_PM25, 25.0f) == 50);
+  CHECK(aqiSubIndex(AQI_VN, AQI_PM25, 50.0f) == 100);
+  CHECK(aqiSubIndex(AQI_CN, AQI_PM25, 75.0f) == 100);
+  CHECK(aqiSubIndex(AQI_CN, AQI_PM25, 115.0f) == 150);
+  CHECK(aqiSubIndex(AQI_US_EPA, AQI_PM25, -1.0f) == -1);
+  CHECK(aqiSubIndex(AQI_US_EPA, AQI_PM25, NAN) == -1);
+  CHECK(aqiSubIndex(AQI_STANDARD_COUNT, AQI_PM25, 10.0f) == -1);
+
+  AqiEngine e = {};
+  CHECK(e.overall(AQI_US_EPA) == -1);
+  e.addPm(AQI_PM25, 0, 40.0f);
+  e.addPm(AQI_PM25, 1, 40.0f);
+  uint8_t who = 0xFF;
+  CHECK(e.overall(AQI_US_EPA, &who) == aqiSubIndex(AQI_US_EPA, AQI_PM25, 40.0f) && who == AQI_PM25);
+  e.setGasSubIndex(300);
+  CHECK(e.overall(AQI_US_EPA, &who) == 300 && who == AQI_POLLUTANT_COUNT);
+}
+
+// ns per call; the sink keeps the optimiser from dropping the work
+static volatile float sink;
+
+static void bench() {
+  typedef std::chrono::steady_clock Clock;
+  NowCast nc = {};
+  for (uint32_t h = 0; h < AQI_NOWCAST_HOURS; h++) nc.add(h, 20.0f + h);
+
+  // One hour per SAMPLES_PER_HOUR samples, so ring advances are included
+  Clock::time_point t0 = Clock::now();
+  for (int i = 0; i < BENCH_ITERS; i++) nc.add(AQI_NOWCAST_HOURS + i / SAMPLES_PER_HOUR, (float)(i & 63));
+  Clock::time_point t1 = Clock::now();
+  // Within the last hour, all 12 buckets full: the full weighting pass
+  const uint32_t last = AQI_NOWCAST_HOURS + (BENCH_ITERS - 1) / SAMPLES_PER_HOUR;
+  float acc = 0.0f;
+  for (int i = 0; i < BENCH_ITERS; i++) {
+    nc.add(last, (float)(i & 63));
+    acc += nc.value();
+  }
+  Clock::time_point t2 = Clock::now();
+  sink = acc;
+  CHECK(std::isfinite(acc));
+
+  double addNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / BENCH_ITERS;
+  double bothNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / BENCH_ITERS;
+  printf("bench: add %.1f ns/op, add+value %.1f ns/op\n", addNs, bothNs);
+}
+
+int main() {
+  testAgainstBruteForce();
+  testNowCastCases();
+  testBreakpoints();
+  bench();
+
+  printf("aqi_test %s (%d failures)\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
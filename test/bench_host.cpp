@@ -0,0 +1,237 @@
+// test/bench_host.cpp
+// Host build of the /api/bench suite for the platform-independent hot
+// paths: the same case names as bench.cpp where the work is the same,
+// steady_clock instead of the cycle counter, and allocations counted by
+// hooking malloc (glibc) and operator new for the measured pass. The
+// queue runs on the RAM filesystem in shim/FS.h, so it times FileQueue
+// itself, not flash. Writes a report tools/bench_compare.py reads:
+//   make -C test bench     # writes test/bench_host.json
+// sample_json and add_log need ArduinoJson and the device, and stay
+// device-only.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "aqi.h"
+#include "file_queue.h"
+#include "mq135_math.h"
+#include "pm_filter.h"
+#include "spike_filter.h"
+
+// =====================================================================
+// Allocation hook
+// =====================================================================
+static bool counting = false;
+static uint64_t allocCount = 0, allocBytes = 0;
+
+static inline void noteAlloc(size_t n) {
+  if (!counting) return;
+  allocCount++;
+  allocBytes += n;
+}
+
+#if defined(__GLIBC__)
+// operator new below calls __libc_malloc, so nothing is counted twice
+extern "C" void *__libc_malloc(size_t);
+extern "C" void *__libc_calloc(size_t, size_t);
+extern "C" void *__libc_realloc(void *, size_t);
+#define RAW_MALLOC __libc_malloc
+
+extern "C" void *malloc(size_t n) {
+  noteAlloc(n);
+  return __libc_malloc(n);
+}
+
+extern "C" void *calloc(size_t count, size_t n) {
+  noteAlloc(count * n);
+  return __libc_calloc(count, n);
+}
+
+extern "C" void *realloc(void *p, size_t n) {
+  noteAlloc(n);
+  return __libc_realloc(p, n);
+}
+#else
+#define RAW_MALLOC malloc
+#endif
+
+void *operator new(size_t n) {
+  noteAlloc(n);
+  void *p = RAW_MALLOC(n ? n : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void *operator new[](size_t n) { return operator new(n); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+// =====================================================================
+// Harness, as runBench() in bench.cpp
+// =====================================================================
+struct BenchResult {
+  const char *name;
+  uint32_t iterations;
+  double nsPerOp;
+  long allocsPerOp;
+  long bytesPerOp;
+};
+
+typedef void (*BenchFn)(uint32_t iterations);
+
+static BenchResult runBench(const char *name, BenchFn fn, uint32_t iterations) {
+  typedef std::chrono::steady_clock Clock;
+  BenchResult r = { name, iterations, 0.0, -1, -1 };
+
+  fn(1);  // warm caches, lazy init
+
+  Clock::time_point start = Clock::now();
+  fn(iterations);
+  r.nsPerOp = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+
+  allocCount = allocBytes = 0;
+  counting = true;
+  fn(iterations);
+  counting = false;
+  r.allocsPerOp = (long)((allocCount + iterations / 2) / iterations);
+  r.bytesPerOp = (long)((allocBytes + iterations / 2) / iterations);
+  return r;
+}
+
+// =====================================================================
+// Cases
+// =====================================================================
+static volatile float sink;
+
+static void benchAqiAdd(uint32_t n) {
+  static AqiEngine engine;
+  for (uint32_t i = 0; i < n; i++) engine.addPm(AQI_PM25, i / 100, 5.0f + (i % 97));
+}
+
+static void benchAqi(uint32_t n) {
+  static AqiEngine engine;
+  int acc = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    engine.addPm(AQI_PM25, i / 64, 20.0f + (i % 31));
+    acc += engine.overall(AQI_US_EPA);
+  }
+  sink = acc;
+}
+
+// GAS_A / GAS_B in mq135.cpp
+#define CURVE_A 70.0f
+#define CURVE_B -3.2f
+#define CURVE_POINTS 1000
+
+static float curveRatio(uint32_t i) {
+  return 0.05f + (i % CURVE_POINTS) * 0.02f;
+}
+
+static void benchCurvePowf(uint32_t n) {
+  float acc = 0;
+  for (uint32_t i = 0; i < n; i++) acc += CURVE_A * powf(curveRatio(i), CURVE_B);
+  sink = acc;
+}
+
+static void benchCurveTable(uint32_t n) {
+  float acc = 0;
+  for (uint32_t i = 0; i < n; i++) acc += mqmath::powerCurve(CURVE_A, CURVE_B, curveRatio(i));
+  sink = acc;
+}
+
+static float curveMaxRelError() {
+  float maxErr = 0;
+  for (uint32_t i = 0; i < CURVE_POINTS; i++) {
+    float r = curveRatio(i);
+    float err = fabsf(mqmath::powerCurve(CURVE_A, CURVE_B, r) / (CURVE_A * powf(r, CURVE_B)) - 1.0f);
+    if (err > maxErr) maxErr = err;
+  }
+  return maxErr;
+}
+
+static void benchPmKalman(uint32_t n) {
+  static PmKalman kf;
+  for (uint32_t i = 0; i < n; i++) kf.update(pmHumidityCorrect(20.0f + (i % 23), 65.2f, 0.4f), 5.0f);
+  sink = kf.value();
+}
+
+static void benchHampel(uint32_t n) {
+  static HampelFilter<7> filter(3.0f, 0.3f);
+  float median = 0;
+  uint32_t spikes = 0;
+  for (uint32_t i = 0; i < n; i++) spikes += filter.check(28.5f + (i % 5) * 0.1f + (i % 101 == 0) * 9.0f, median);
+  sink = median + spikes;
+}
+
+// A typical sampleToJson() record
+static const char *BENCH_RECORD =
+    "{\"t\":28.5,\"h\":65.2,\"p\":1012.3,\"pm\":35,\"aqi\":99,\"mq\":450,\"pm_sd\":4.7,"
+    "\"dp\":21.3,\"hi\":32.1,\"ah\":18.62,\"slp\":1015.2,\"ts\":1760000000000000}";
+
+static fs::FS benchFs;
+static FileQueue benchQueue(benchFs, "/bq");
+
+static void benchQueueAppend(uint32_t n) {
+  String json(BENCH_RECORD);
+  for (uint32_t i = 0; i < n; i++) benchQueue.append(json);
+}
+
+// Publish left out, as on the device; the copy stands in for fixupTimestamp
+static bool benchPublish(const String &record) {
+  String out = record;
+  return out.length() > 0;
+}
+
+static void benchQueueDrain(uint32_t n) {
+  benchQueue.drain(benchPublish, n);
+}
+
+// =====================================================================
+// Report, in the /api/bench format
+// =====================================================================
+int main(int argc, char **argv) {
+  const char *path = argc > 1 ? argv[1] : nullptr;
+
+  std::vector<BenchResult> results;
+  results.push_back(runBench("aqi_bucket_add", benchAqiAdd, 1000000));
+  results.push_back(runBench("aqi_nowcast", benchAqi, 1000000));
+  results.push_back(runBench("mq135_curve_powf", benchCurvePowf, 100 * CURVE_POINTS));
+  results.push_back(runBench("mq135_curve_table", benchCurveTable, 100 * CURVE_POINTS));
+  results.push_back(runBench("pm_kalman_update", benchPmKalman, 1000000));
+  results.push_back(runBench("hampel_check", benchHampel, 1000000));
+
+  float amplification = -1.0f;
+  if (benchQueue.begin()) {
+    results.push_back(runBench("queue_append_ramfs", benchQueueAppend, 20000));
+    results.push_back(runBench("queue_drain_record", benchQueueDrain, 20000));
+    amplification = benchQueue.writeAmplification();
+    benchQueue.drain(benchPublish);
+    benchQueue.erase();
+  }
+
+  FILE *out = path ? fopen(path, "w") : stdout;
+  if (!out) {
+    printf("cannot write %s\n", path);
+    return 1;
+  }
+  fprintf(out, "{\"build\":\"%s %s\",\"sdk\":\"host gcc %s\",\"cpu_mhz\":0,\"results\":[", __DATE__, __TIME__, __VERSION__);
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchResult &r = results[i];
+    fprintf(out, "%s{\"name\":\"%s\",\"iterations\":%u,\"ns_per_op\":%.1f,\"allocs_per_op\":%ld,\"bytes_per_op\":%ld}",
+            i ? "," : "", r.name, r.iterations, r.nsPerOp, r.allocsPerOp, r.bytesPerOp);
+  }
+  fprintf(out, "],\"mq135_curve_max_rel_err\":%g", curveMaxRelError());
+  if (amplification >= 0.0f) fprintf(out, ",\"queue_write_amplification\":%g", amplification);
+  fprintf(out, "}\n");
+  if (path) fclose(out);
+
+  for (const BenchResult &r : results) {
+    fprintf(stderr, "%-22s %10.1f ns/op %4ld allocs/op %6ld bytes/op\n", r.name, r.nsPerOp, r.allocsPerOp, r.bytesPerOp);
+  }
+  return 0;
+}
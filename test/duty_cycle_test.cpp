@@ -0,0 +1,153 @@
+// test/duty_cycle_test.cpp
+// Drives the DutyCycle state machine (low_power.h) with a simulated clock
+// through the warm-up, publishEvery, connect-timeout and publish paths.
+// Run with `make -C test`.
+#include <cstdio>
+
+#include "low_power.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                              \
+  do {                                                           \
+    if (!(cond)) {                                               \
+      printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                                \
+    }                                                            \
+  } while (0)
+
+// --- Simulated hardware ---
+struct Sim {
+  uint32_t now;
+  uint16_t buffered;
+  uint32_t readyAtMs;  // networkReady() true from then on, UINT32_MAX = never
+  uint32_t samples, networkStarts, published, sleeps;
+  uint32_t sleptMs;
+  uint32_t sampledAt;
+};
+
+static Sim sim;
+
+static uint32_t simNow() { return sim.now; }
+static void simWarmup() {}
+static bool simSample() {
+  sim.samples++;
+  sim.sampledAt = sim.now;
+  sim.buffered++;
+  return true;
+}
+static uint16_t simBuffered() { return sim.buffered; }
+static void simStartNetwork() { sim.networkStarts++; }
+static bool simNetworkReady() { return sim.now >= sim.readyAtMs; }
+static bool simPublishOne() {
+  sim.buffered--;
+  sim.published++;
+  return true;
+}
+static void simSleep(uint32_t ms) {
+  sim.sleeps++;
+  sim.sleptMs = ms;
+}
+
+static const DutyCycleHal hal = { simNow, simWarmup, simSample, simBuffered, simStartNetwork,
+                                  simNetworkReady, simPublishOne, simSleep };
+
+static const DutyCycleConfig cfg = {
+  60000,  // wakeIntervalMs
+  2000,   // warmupMs
+  20000,  // connectTimeoutMs
+  5,      // publishEvery
+  96,     // bufferCapacity
+};
+
+// One wake from t = 0, stepping the clock by tickMs until DUTY_DONE
+static void runWake(const DutyCycleConfig &c, uint32_t wakeCount, uint16_t buffered, uint32_t readyAtMs,
+                    uint32_t tickMs = 10) {
+  sim = Sim();
+  sim.buffered = buffered;
+  sim.readyAtMs = readyAtMs;
+  DutyCycle cycle(c, hal, wakeCount);
+  for (int guard = 0; cycle.step() != DUTY_DONE && guard < 1000000; guard++) sim.now += tickMs;
+}
+
+static void testWarmup() {
+  sim = Sim();
+  sim.readyAtMs = UINT32_MAX;
+  DutyCycle cycle(cfg, hal, 1);
+  while (sim.now < cfg.warmupMs) {
+    CHECK(cycle.step() == DUTY_WARMUP);
+    sim.now += 100;
+  }
+  CHECK(sim.samples == 0);
+  CHECK(cycle.step() == DUTY_SAMPLE);
+  cycle.step();
+  CHECK(sim.samples == 1);
+  CHECK(sim.sampledAt == cfg.warmupMs);
+}
+
+// Off-cycle wake: sample and sleep, radio never started, fixed period kept
+static void testSampleOnly() {
+  runWake(cfg, 3, 2, 0);
+  CHECK(sim.samples == 1);
+  CHECK(sim.networkStarts == 0);
+  CHECK(sim.published == 0);
+  CHECK(sim.buffered == 3);
+  CHECK(sim.sleeps == 1);
+  CHECK(sim.sleptMs == cfg.wakeIntervalMs - sim.now);
+}
+
+// Every publishEvery-th wake connects and drains the whole ring
+static void testPublish() {
+  runWake(cfg, 5, 4, 3000);
+  CHECK(sim.networkStarts == 1);
+  CHECK(sim.published == 5);
+  CHECK(sim.buffered == 0);
+  CHECK(sim.sleeps == 1);
+}
+
+// A full ring publishes early, whatever the wake count
+static void testBufferFull() {
+  runWake(cfg, 3, cfg.bufferCapacity, 0);
+  CHECK(sim.networkStarts == 1);
+  CHECK(sim.buffered == 0);
+}
+
+// No network: give up after connectTimeoutMs and keep the batch
+static void testConnectTimeout() {
+  runWake(cfg, 10, 4, UINT32_MAX);
+  CHECK(sim.networkStarts == 1);
+  CHECK(sim.published == 0);
+  CHECK(sim.buffered == 5);
+  CHECK(sim.now >= cfg.warmupMs + cfg.connectTimeoutMs);
+  CHECK(sim.now < cfg.warmupMs + cfg.connectTimeoutMs + 100);
+  CHECK(sim.sleptMs == cfg.wakeIntervalMs - sim.now);
+}
+
+// A wake longer than the period still sleeps the 1 s minimum
+static void testMinimumSleep() {
+  DutyCycleConfig c = cfg;
+  c.wakeIntervalMs = 10000;
+  runWake(c, 10, 0, UINT32_MAX);
+  CHECK(sim.sleptMs == 1000);
+}
+
+// publishEvery 0 or 1 publishes on every wake
+static void testPublishEveryWake() {
+  DutyCycleConfig c = cfg;
+  c.publishEvery = 1;
+  runWake(c, 7, 0, 0);
+  CHECK(sim.networkStarts == 1);
+  CHECK(sim.published == 1);
+}
+
+int main() {
+  testWarmup();
+  testSampleOnly();
+  testPublish();
+  testBufferFull();
+  testConnectTimeout();
+  testMinimumSleep();
+  testPublishEveryWake();
+  printf("duty_cycle %s (%d failures)\n", failures ? "FAILED" : "ok", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,75 @@
+// test/mq135_math_test.cpp
+// Sweeps the table-driven log2 / exp2 / power curve in mq135_math.h
+// against the libm float functions and asserts the bounds stated in the
+// header. Run with `make -C test`.
+#include <cmath>
+#include <cstdio>
+
+#include "mq135_math.h"
+
+static int failures = 0;
+
+static void expectBelow(const char *what, double worst, double bound, double at) {
+  bool ok = worst <= bound;
+  printf("%-28s max err %.3g (bound %.3g) at %g%s\n", what, worst, bound, at, ok ? "" : "  FAILED");
+  if (!ok) failures++;
+}
+
+// Ratios 0.01 .. 100, geometric, dense enough to hit every table segment
+template <typename Fn>
+static void sweepRatios(Fn fn) {
+  for (float r = 0.01f; r <= 100.0f; r *= 1.0001f) fn(r);
+}
+
+int main() {
+  double worst = 0, at = 0;
+  sweepRatios([&](float r) {
+    double err = fabs((double)mqmath::fastLog2(r) - log2f(r));
+    if (err > worst) worst = err, at = r;
+  });
+  expectBelow("fastLog2 (abs)", worst, mqmath::LOG2_MAX_ERR, at);
+
+  worst = 0;
+  for (float y = -20.0f; y <= 20.0f; y += 0.0001f) {
+    double err = fabs((double)mqmath::fastExp2(y) / exp2f(y) - 1.0);
+    if (err > worst) worst = err, at = y;
+  }
+  expectBelow("fastExp2 (rel)", worst, mqmath::EXP2_MAX_REL_ERR, at);
+
+  // Exponents of the MQ-series datasheet curves, up to the |b| <= 3.2 the bound covers
+  const float exponents[] = { -3.2f, -2.5f, -1.5f, -0.5f, 1.0f };
+  for (float b : exponents) {
+    worst = 0;
+    sweepRatios([&](float r) {
+      double err = fabs((double)mqmath::powerCurve(70.0f, b, r) / (70.0f * powf(r, b)) - 1.0);
+      if (err > worst) worst = err, at = r;
+    });
+    char name[40];
+    snprintf(name, sizeof(name), "powerCurve b=%.1f (rel)", b);
+    expectBelow(name, worst, mqmath::CURVE_MAX_REL_ERR, at);
+  }
+
+  // Corrected index as MQ135::getCorrectedIndex computes it, over
+  // -20 .. 60 °C and 0 .. 100 %RH, against powf on the corrected ratio
+  worst = 0;
+  for (float t = -20.0f; t <= 60.0f; t += 0.5f) {
+    for (float h = 0.0f; h <= 100.0f; h += 1.0f) {
+      float cf = mqmath::correction(t, h);
+      for (float r = 0.01f; r <= 100.0f; r *= 1.01f) {
+        float ratio = r * cf;
+        double err = fabs((double)mqmath::powerCurve(70.0f, -3.2f, ratio) / (70.0f * powf(ratio, -3.2f)) - 1.0);
+        if (err > worst) worst = err, at = ratio;
+      }
+    }
+  }
+  expectBelow("corrected index (rel)", worst, mqmath::CURVE_MAX_REL_ERR, at);
+
+  // The correction itself: 1 at the reference point, falling with T and RH
+  bool shapeOk = fabsf(mqmath::correction(20.0f, 55.0f) - 1.0f) < 1e-6f &&
+                 mqmath::correction(30.0f, 55.0f) < 1.0f && mqmath::correction(20.0f, 80.0f) < 1.0f;
+  printf("%-28s %s\n", "correction shape", shapeOk ? "ok" : "FAILED");
+  if (!shapeOk) failures++;
+
+  printf("mq135_math %s (%d failures)\n", failures ? "FAILED" : "ok", failures);
+  return failures ? 1 : 0;
+}
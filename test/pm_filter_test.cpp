@@ -0,0 +1,125 @@
+// test/pm_filter_test.cpp
+// Replays a PM step trace (data/pm_step.txt) through pm_filter.h the way
+// DustDriver::read does and checks the figures quoted for the filter: RMSE
+// against the true level of 8.2 raw, 5.6 for a 10-sample moving average and
+// 3.7 filtered, and the new level reached on the first sample after the
+// step. Also checks the humidity correction. Run with `make -C test`.
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "pm_filter.h"
+
+#define TRACE_FILE "data/pm_step.txt"
+#define MA_LEN 10
+#define FIGURE_TOL 0.05  // figures are quoted to one decimal
+
+static int failures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                                     \
+    }                                                                 \
+  } while (0)
+
+struct Reading {
+  float dt, truth, raw;
+};
+
+static std::vector<Reading> loadTrace(const char *path) {
+  std::vector<Reading> trace;
+  FILE *f = fopen(path, "r");
+  if (!f) return trace;
+  char line[128];
+  Reading r;
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#') continue;
+    if (sscanf(line, "%f %f %f", &r.dt, &r.truth, &r.raw) == 3) trace.push_back(r);
+  }
+  fclose(f);
+  return trace;
+}
+
+static void testHumidity() {
+  CHECK(pmHumidityCorrect(50.0f, 80.0f, 0.0f) == 50.0f);  // kappa 0: off
+  CHECK(pmHumidityCorrect(50.0f, NAN, 0.4f) == 50.0f);    // no RH: unchanged
+  CHECK(pmHumidityCorrect(50.0f, 0.0f, 0.4f) == 50.0f);   // dry air: no growth
+  CHECK(pmHumidityCorrect(50.0f, -5.0f, 0.4f) == 50.0f);
+  // RH 50 %, kappa 0.4: growth 1 + 0.4 * 0.5 / 0.5 = 1.4
+  CHECK(fabsf(pmHumidityCorrect(70.0f, 50.0f, 0.4f) - 50.0f) < 1e-4f);
+  // Capped at 95 %
+  CHECK(pmHumidityCorrect(50.0f, 100.0f, 0.4f) == pmHumidityCorrect(50.0f, PM_RH_CAP, 0.4f));
+  // More humidity, more correction
+  CHECK(pmHumidityCorrect(50.0f, 90.0f, 0.4f) < pmHumidityCorrect(50.0f, 60.0f, 0.4f));
+}
+
+static void testGuards() {
+  PmKalman kf;
+  CHECK(std::isnan(kf.value()) && std::isnan(kf.sd()));
+  CHECK(std::isnan(kf.update(NAN, 5.0f)));  // NaN before init stays uninitialised
+  CHECK(kf.update(30.0f, 0.0f) == 30.0f);   // first reading taken as is
+  CHECK(fabsf(kf.sd() - PM_KF_MEAS_SD) < 1e-4f);
+  CHECK(kf.update(NAN, 5.0f) == 30.0f);     // NaN skipped
+  CHECK(kf.update(0.0f, 5.0f) >= 0.0f);     // never negative
+  kf.reset();
+  CHECK(std::isnan(kf.value()));
+}
+
+int main(int argc, char **argv) {
+  const char *path = argc > 1 ? argv[1] : TRACE_FILE;
+  std::vector<Reading> trace = loadTrace(path);
+  if (trace.size() < 2 * MA_LEN) {
+    printf("cannot read trace %s\n", path);
+    return 1;
+  }
+
+  testHumidity();
+  testGuards();
+
+  PmKalman kf;
+  double seRaw = 0, seMa = 0, seKf = 0;
+  float window[MA_LEN];
+  size_t stepAt = 0;
+  float atStep = NAN, sdBefore = NAN;
+
+  for (size_t i = 0; i < trace.size(); i++) {
+    const Reading &r = trace[i];
+    float x = kf.update(r.raw, i ? r.dt : 0.0f);
+
+    window[i % MA_LEN] = r.raw;
+    size_t n = i + 1 < MA_LEN ? i + 1 : MA_LEN;
+    double sum = 0;
+    for (size_t j = 0; j < n; j++) sum += window[j];
+    double ma = sum / n;
+
+    seRaw += (r.raw - r.truth) * (r.raw - r.truth);
+    seMa += (ma - r.truth) * (ma - r.truth);
+    seKf += (x - r.truth) * (x - r.truth);
+
+    if (!stepAt && i > 0 && r.truth != trace[i - 1].truth) {
+      stepAt = i;
+      atStep = x;
+    }
+    if (!stepAt) sdBefore = kf.sd();
+  }
+
+  double n = trace.size();
+  double rmseRaw = sqrt(seRaw / n), rmseMa = sqrt(seMa / n), rmseKf = sqrt(seKf / n);
+  printf("rmse raw %.2f  ma%d %.2f  kalman %.2f  first after step %.1f (true %.0f)\n",
+         rmseRaw, MA_LEN, rmseMa, rmseKf, atStep, trace[stepAt].truth);
+
+  CHECK(fabs(rmseRaw - 8.2) < FIGURE_TOL);
+  CHECK(fabs(rmseMa - 5.6) < FIGURE_TOL);
+  CHECK(fabs(rmseKf - 3.7) < FIGURE_TOL);
+  CHECK(stepAt > 0);
+  // Gate opened: the first filtered value is within one reading's noise
+  CHECK(fabsf(atStep - trace[stepAt].truth) < PM_KF_MEAS_SD);
+  // Settled before and after the step: steady-state sd at 5 s is about 4.7
+  CHECK(sdBefore < PM_KF_MEAS_SD * 0.6f);
+  CHECK(kf.sd() < PM_KF_MEAS_SD * 0.6f);
+
+  printf("pm_filter_test %s (%d failures)\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
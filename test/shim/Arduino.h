@@ -0,0 +1,29 @@
+// test/shim/Arduino.h
+#pragma once
+// Just enough of the Arduino core for the host tests
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+class String {
+public:
+  String() {}
+  String(const char *s) : _s(s) {}
+  String(const std::string &s) : _s(s) {}
+
+  size_t length() const { return _s.size(); }
+  const char *c_str() const { return _s.c_str(); }
+  char operator[](size_t i) const { return _s[i]; }
+  bool operator==(const String &o) const { return _s == o._s; }
+  bool operator!=(const String &o) const { return _s != o._s; }
+  String &operator+=(char c) {
+    _s += c;
+    return *this;
+  }
+
+private:
+  std::string _s;
+};
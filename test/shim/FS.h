@@ -0,0 +1,132 @@
+// test/shim/FS.h
+#pragma once
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+
+#include "Arduino.h"
+
+// =====================================================================
+// RAM-backed fs::FS with power-loss injection. Every mutating call
+// (truncating open, write, remove, rename) is one operation; after
+// cutAfter() operations the next one throws PowerCut. A write that is cut
+// keeps a random prefix of its bytes, like a torn flash program. State is
+// global, so a FileQueue built after the cut sees what survived.
+// =====================================================================
+struct PowerCut {};
+
+class RamFs {
+public:
+  std::map<std::string, std::string> files;
+  uint64_t bytesWritten = 0;
+
+  void cutAfter(long ops) { _opsLeft = ops; }
+  void seed(uint32_t s) { _rng.seed(s); }
+
+  // Called before each mutation; keep = bytes of a write that survive a cut
+  void op(std::string *data = nullptr, const char *bytes = nullptr, size_t n = 0) {
+    if (_opsLeft < 0 || _opsLeft-- > 0) return;
+    _opsLeft = -1;
+    if (data && n) data->append(bytes, std::uniform_int_distribution<size_t>(0, n - 1)(_rng));
+    throw PowerCut();
+  }
+
+  static RamFs &instance() {
+    static RamFs fs;
+    return fs;
+  }
+
+private:
+  long _opsLeft = -1;
+  std::mt19937 _rng;
+};
+
+namespace fs {
+
+enum SeekMode { SeekSet };
+
+class File {
+public:
+  File() {}
+  File(const std::string &path) : _path(path), _open(true) {}
+
+  operator bool() const { return _open; }
+  void close() { _open = false; }
+  size_t size() const { return data().size(); }
+
+  bool seek(uint32_t pos, SeekMode = SeekSet) {
+    _pos = pos;
+    return pos <= size();
+  }
+
+  size_t readBytes(char *buf, size_t n) {
+    const std::string &d = data();
+    size_t k = _pos < d.size() ? std::min(n, d.size() - _pos) : 0;
+    memcpy(buf, d.data() + _pos, k);
+    _pos += k;
+    return k;
+  }
+
+  String readStringUntil(char term) {
+    const std::string &d = data();
+    String out;
+    while (_pos < d.size() && d[_pos] != term) out += d[_pos++];
+    if (_pos < d.size()) _pos++;
+    return out;
+  }
+
+  size_t write(const uint8_t *buf, size_t n) {
+    RamFs &ram = RamFs::instance();
+    std::string &d = ram.files[_path];
+    ram.op(&d, (const char *)buf, n);
+    d.append((const char *)buf, n);
+    ram.bytesWritten += n;
+    return n;
+  }
+
+  size_t print(const String &s) { return write((const uint8_t *)s.c_str(), s.length()); }
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+
+private:
+  std::string _path;
+  size_t _pos = 0;
+  bool _open = false;
+
+  std::string &data() const { return RamFs::instance().files[_path]; }
+};
+
+class FS {
+public:
+  File open(const char *path, const char *mode = "r") {
+    RamFs &ram = RamFs::instance();
+    if (mode[0] == 'r' && !ram.files.count(path)) return File();
+    if (mode[0] == 'w') {
+      ram.op();
+      ram.files[path].clear();
+    }
+    ram.files[path];  // "a" creates the file
+    return File(path);
+  }
+
+  bool exists(const char *path) { return RamFs::instance().files.count(path) > 0; }
+
+  bool remove(const char *path) {
+    RamFs &ram = RamFs::instance();
+    ram.op();
+    return ram.files.erase(path) > 0;
+  }
+
+  bool rename(const char *from, const char *to) {
+    RamFs &ram = RamFs::instance();
+    ram.op();
+    if (!ram.files.count(from)) return false;
+    ram.files[to] = ram.files[from];
+    ram.files.erase(from);
+    return true;
+  }
+};
+
+}  // namespace fs
+
+using fs::File;
@@ -0,0 +1,91 @@
+// timebase.cpp
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_sntp.h>
+#include <sys/time.h>
+
+#include "timebase.h"
+#include "config.h"
+#include "boot_profiler.h"
+#include "trace.h"
+
+// Anything before 2023-01-01 is treated as an unsynced clock
+#define MIN_VALID_EPOCH 1672531200ULL
+
+// RTC memory keeps the boot-relative clock continuous across deep sleep;
+// it is cleared on power-on and reset, which starts a new boot ID.
+RTC_DATA_ATTR static uint32_t currentBootId = 0;
+RTC_DATA_ATTR static bool synced = false;
+RTC_DATA_ATTR static int64_t epochOffsetUs = 0;  // epoch µs at monotonic 0
+RTC_DATA_ATTR static uint64_t sleepMonoBase = 0;  // µs accumulated in earlier wakes + sleeps
+
+static uint64_t wallMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (uint64_t)tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+static void captureOffset() {
+  uint64_t mono = monoMicros();
+  uint64_t wall = wallMicros();
+  if (wall / 1000000ULL < MIN_VALID_EPOCH) return;
+
+  epochOffsetUs = (int64_t)wall - (int64_t)mono;
+  if (!synced) addLog("[TIME] Wall clock synced, resolving boot-relative timestamps");
+  synced = true;
+  bootPhaseEnd(BOOT_NTP);
+  bootSetReady(BOOT_READY_TIME);
+}
+
+static void onTimeSync(struct timeval *tv) {
+  traceAsyncEnd(TR_NTP);
+  captureOffset();
+}
+
+void timebaseInit() {
+  if (currentBootId == 0) currentBootId = esp_random() | 1;
+  sntp_set_time_sync_notification_cb(onTimeSync);
+  addLogf("[TIME] Boot ID %08x", currentBootId);
+}
+
+uint32_t bootId() {
+  return currentBootId;
+}
+
+uint64_t monoMicros() {
+  return sleepMonoBase + (uint64_t)esp_timer_get_time();
+}
+
+void timebasePrepareSleep(uint64_t sleepUs) {
+  sleepMonoBase = monoMicros() + sleepUs;
+}
+
+bool timeSynced() {
+  if (!synced) captureOffset();  // wall clock may have been set without a callback
+  return synced;
+}
+
+bool monoToEpoch(uint32_t boot, uint64_t mono, uint64_t &epoch) {
+  if (boot != currentBootId || !timeSynced()) return false;
+  epoch = (uint64_t)((int64_t)mono + epochOffsetUs);
+  return true;
+}
+
+String fixupTimestamp(const String &json) {
+  if (json.indexOf("\"bt\"") < 0 || !timeSynced()) return json;
+
+  StaticJsonDocument<1536> doc;
+  if (deserializeJson(doc, json)) return json;
+  if (doc.containsKey("ts")) return json;
+
+  uint64_t epoch;
+  if (!monoToEpoch(doc["boot"].as<uint32_t>(), doc["bt"].as<uint64_t>(), epoch)) return json;
+
+  doc.remove("bt");
+  doc.remove("boot");
+  doc["ts"] = epoch;
+
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
@@ -0,0 +1,19 @@
+// timebase.h
+#pragma once
+#include <Arduino.h>
+
+// Samples are captured on the monotonic boot clock and only converted to
+// epoch time at serialization, once SNTP has produced a valid wall clock.
+void timebaseInit();
+uint32_t bootId();
+uint64_t monoMicros();
+bool timeSynced();
+
+// Call right before deep sleep so the clock carries over to the next wake
+void timebasePrepareSleep(uint64_t sleepUs);
+
+// Convert a capture from this boot to epoch µs; false if not possible yet
+bool monoToEpoch(uint32_t boot, uint64_t mono, uint64_t &epoch);
+
+// Adds "ts" to a queued payload that only carries "bt"/"boot" if it can now be resolved
+String fixupTimestamp(const String &json);
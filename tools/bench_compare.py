@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""Compare two /api/bench reports and flag regressions.
+
+    curl -X POST http://<device>/api/bench      # start a run
+    curl http://<device>/api/bench > new.json   # a second or two later
+    tools/bench_compare.py base.json new.json
+
+Reports from the host build (make -C test bench, test/bench_host.json)
+have the same format; compare host reports with host reports.
+
+A case regresses when ns_per_op grows by more than --threshold (relative),
+or when allocs_per_op / bytes_per_op grow at all (both runs measured).
+Exits 1 if anything regressed, so it can gate a release.
+"""
+import argparse
+import json
+import sys
+
+# Report-level numbers where higher is worse
+SCALARS = ("queue_write_amplification", "mq135_curve_max_rel_err")
+
+
+def load(path):
+    with open(path) as f:
+        report = json.load(f)
+    return report, {r["name"]: r for r in report.get("results", [])}
+
+
+def pct(old, new):
+    return (new - old) / old * 100.0 if old else 0.0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("base")
+    ap.add_argument("new")
+    ap.add_argument("--threshold", type=float, default=0.10,
+                    help="allowed relative ns_per_op growth (default 0.10)")
+    args = ap.parse_args()
+
+    base, base_cases = load(args.base)
+    new, new_cases = load(args.new)
+
+    for key in ("build", "sdk", "cpu_mhz"):
+        print(f"{key:8} {base.get(key)!s:24} -> {new.get(key)}")
+    if base.get("cpu_mhz") != new.get("cpu_mhz"):
+        print("warning: CPU clock differs, ns_per_op is not comparable")
+    print()
+
+    regressions = []
+    print(f"{'case (ns/op)':26} {'base':>10} {'new':>10} {'delta':>8}  allocs  bytes")
+    for name, old in base_cases.items():
+        cur = new_cases.get(name)
+        if cur is None:
+            print(f"{name:26} missing from new report")
+            continue
+        delta = pct(old["ns_per_op"], cur["ns_per_op"])
+        flags = []
+        if delta > args.threshold * 100.0:
+            flags.append("slower")
+        for field in ("allocs_per_op", "bytes_per_op"):
+            if old[field] >= 0 and cur[field] > old[field]:
+                flags.append(field.split("_")[0] + " up")
+        print(f"{name:26} {old['ns_per_op']:>10} {cur['ns_per_op']:>10} {delta:>+7.1f}%"
+              f"  {old['allocs_per_op']:>2}->{cur['allocs_per_op']:<2}"
+              f" {old['bytes_per_op']:>4}->{cur['bytes_per_op']:<4}"
+              f" {'  REGRESSION: ' + ', '.join(flags) if flags else ''}")
+        if flags:
+            regressions.append(name)
+    for name in new_cases.keys() - base_cases.keys():
+        print(f"{name:26} new case")
+
+    for key in SCALARS:
+        if key in base and key in new:
+            worse = new[key] > base[key] * (1.0 + args.threshold)
+            print(f"{key:26} {base[key]:>10.4g} {new[key]:>10.4g}{'  REGRESSION' if worse else ''}")
+            if worse:
+                regressions.append(key)
+
+    if regressions:
+        print(f"\n{len(regressions)} regression(s): {', '.join(regressions)}")
+        return 1
+    print("\nno regressions")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
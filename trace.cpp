@@ -0,0 +1,121 @@
+// trace.cpp
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+
+#include "trace.h"
+
+extern AsyncWebServer server;
+
+#define TRACE_MASK (TRACE_EVENTS - 1)
+#define TRACE_TASK_OTHER TRACE_TASKS
+
+static const char* const traceSpanNames[TR_SPAN_COUNT] = {
+  "sample", "serialize", "ws_broadcast", "mqtt_publish", "queue_flush", "wifi_scan", "ntp", "ota_chunk"
+};
+
+// seq is 0 while a slot is being written and index + 1 once it is complete
+struct TraceSlot {
+  std::atomic<uint32_t> seq;
+  uint32_t ts;  // low 32 bits of esp_timer_get_time()
+  uint8_t span;
+  char phase;
+  uint8_t core;
+  uint8_t task;
+};
+
+static TraceSlot ring[TRACE_EVENTS];
+static std::atomic<uint32_t> head(0);
+
+// Task handle -> small id, claimed on a task's first event
+static std::atomic<uintptr_t> taskHandles[TRACE_TASKS];
+static char taskNames[TRACE_TASKS][16];
+
+static uint8_t taskId() {
+  uintptr_t self = (uintptr_t)xTaskGetCurrentTaskHandle();
+  for (uint8_t i = 0; i < TRACE_TASKS; i++) {
+    uintptr_t h = taskHandles[i].load(std::memory_order_acquire);
+    if (h == self) return i;
+    if (h != 0) continue;
+
+    uintptr_t expected = 0;
+    if (taskHandles[i].compare_exchange_strong(expected, self)) {
+      strncpy(taskNames[i], pcTaskGetName(NULL), sizeof(taskNames[i]) - 1);
+      return i;
+    }
+    if (expected == self) return i;
+  }
+  return TRACE_TASK_OTHER;
+}
+
+void traceEvent(TraceSpan span, char phase) {
+  uint32_t idx = head.fetch_add(1, std::memory_order_relaxed);
+  TraceSlot &s = ring[idx & TRACE_MASK];
+
+  s.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  s.ts = (uint32_t)esp_timer_get_time();
+  s.span = span;
+  s.phase = phase;
+  s.core = xPortGetCoreID();
+  s.task = taskId();
+  s.seq.store(idx + 1, std::memory_order_release);
+}
+
+// =====================================================================
+// Chrome trace-event export
+// =====================================================================
+static bool readSlot(uint32_t idx, TraceSlot &out) {
+  const TraceSlot &s = ring[idx & TRACE_MASK];
+  uint32_t before = s.seq.load(std::memory_order_acquire);
+  if (before != idx + 1) return false;  // overwritten or still being written
+  out.ts = s.ts;
+  out.span = s.span;
+  out.phase = s.phase;
+  out.core = s.core;
+  out.task = s.task;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return s.seq.load(std::memory_order_relaxed) == before;
+}
+
+static void printTrace(Print &out) {
+  uint32_t end = head.load(std::memory_order_acquire);
+  uint32_t start = end > TRACE_EVENTS ? end - TRACE_EVENTS : 0;
+  int64_t now = esp_timer_get_time();
+
+  out.print("{\"traceEvents\":[");
+  out.print("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"weather-esp32\"}}");
+  for (uint8_t i = 0; i <= TRACE_TASKS; i++) {
+    if (i < TRACE_TASKS && taskHandles[i].load(std::memory_order_acquire) == 0) continue;
+    out.printf(",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", i,
+               i < TRACE_TASKS ? taskNames[i] : "other");
+  }
+
+  uint32_t lost = start;
+  for (uint32_t idx = start; idx < end; idx++) {
+    TraceSlot e;
+    if (!readSlot(idx, e) || e.span >= TR_SPAN_COUNT) {
+      lost++;
+      continue;
+    }
+    // Widen against the current time; fine for events under 71 minutes old
+    int64_t ts = now - (int64_t)(uint32_t)((uint32_t)now - e.ts);
+
+    out.printf(",{\"name\":\"%s\",\"cat\":\"fw\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":1,\"tid\":%u",
+               traceSpanNames[e.span], e.phase, (long long)ts, e.task);
+    if (e.phase == 'b' || e.phase == 'e') out.printf(",\"id\":%u", e.span);
+    if (e.phase == 'i') out.print(",\"s\":\"t\"");
+    out.printf(",\"args\":{\"core\":%u}}", e.core);
+  }
+
+  out.printf("],\"displayTimeUnit\":\"ms\",\"otherData\":{\"recorded\":%u,\"lost\":%u,\"capacity\":%u}}", end, lost,
+             TRACE_EVENTS);
+}
+
+void setupTraceRoutes() {
+  server.on("/api/trace", HTTP_GET, [](AsyncWebServerRequest *request) {
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    printTrace(*response);
+    request->send(response);
+  });
+}
@@ -0,0 +1,53 @@
+// trace.h
+#pragma once
+#include <Arduino.h>
+
+// =====================================================================
+// Span tracer: a fixed ring of TRACE_EVENTS begin/end events with µs
+// timestamps (esp_timer), the recording task and its core. Recording is
+// lock-free: a writer claims a slot with one atomic increment and
+// publishes it with a sequence word, so any task on either core may
+// trace. The oldest events are overwritten.
+//
+// GET /api/trace dumps the ring as Chrome trace-event JSON; open it in
+// chrome://tracing or ui.perfetto.dev.
+//
+// Spans that start and end in the same task use TRACE_SCOPE (B/E pairs
+// must nest per task). Spans that complete elsewhere or many loop()
+// iterations later (WiFi scan, NTP) use traceAsyncBegin/End.
+// =====================================================================
+enum TraceSpan : uint8_t {
+  TR_SAMPLE,        // readSensors
+  TR_SERIALIZE,     // sampleToJson of the live sample, in loop()
+  TR_WS_BROADCAST,  // notifyClients
+  TR_MQTT_PUBLISH,  // one PubSubClient publish
+  TR_QUEUE_FLUSH,   // sendQueue, RAM queue to flash
+  TR_WIFI_SCAN,     // async: scan start to results
+  TR_NTP,           // async: SNTP configured to synced
+  TR_OTA_CHUNK,     // one firmware chunk written
+  TR_SPAN_COUNT
+};
+
+#define TRACE_EVENTS 256  // power of two; ~12 bytes each
+#define TRACE_TASKS 8     // distinct tasks named in the dump
+
+void traceEvent(TraceSpan span, char phase);
+
+inline void traceBegin(TraceSpan span) { traceEvent(span, 'B'); }
+inline void traceEnd(TraceSpan span) { traceEvent(span, 'E'); }
+inline void traceAsyncBegin(TraceSpan span) { traceEvent(span, 'b'); }
+inline void traceAsyncEnd(TraceSpan span) { traceEvent(span, 'e'); }
+inline void traceInstant(TraceSpan span) { traceEvent(span, 'i'); }
+
+class TraceScope {
+public:
+  explicit TraceScope(TraceSpan span) : _span(span) { traceBegin(span); }
+  ~TraceScope() { traceEnd(_span); }
+
+private:
+  TraceSpan _span;
+};
+
+#define TRACE_SCOPE(span) TraceScope traceScope_(span)
+
+void setupTraceRoutes();
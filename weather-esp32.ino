@@ -11,9 +11,19 @@
 #include "mq135.h"
 #include "calibrate.h"
 #include "mqtt_handler.h"  // loopMQTT(), sendMQTT()
+#include "aggregator.h"
+#include "timebase.h"
+#include "low_power.h"
+#include "boot_profiler.h"
+#include "config_schema.h"
+#include "loop_monitor.h"
+#include "heap_monitor.h"
+#include "trace.h"
+#include "sensor_drivers.h"  // SensorRegistry::sysinfo
 
 // --- Global Objects ---
 const unsigned long SYSTEM_INFO_INTERVAL = 10000;
+const unsigned long LOW_POWER_CONFIG_WINDOW = 180000;
 
 WiFiClient wifiClient;
 PubSubClient mqttClient(wifiClient);
@@ -28,70 +38,153 @@ void logAppConfig() {
   addLogf("MQTT Server: %s:%d", appConfig.mqttServer, appConfig.mqttPort);
   addLogf("MQTT Topic: %s", appConfig.mqttTopic);
   addLogf("Send Interval: %lu ms", appConfig.sendInterval);
+  addLogf("Publish Window: %lu s", appConfig.publishWindow);
 
   addLogf("Dust LED Pin: %d, Dust ADC Pin: %d", appConfig.dustLEDPin, appConfig.dustADCPin);
   addLogf("MQ135 ADC Pin: %d", appConfig.mqADCPin);
 
+  if (appConfig.lowPowerMode) {
+    addLogf("Low Power: wake every %u s, publish every %u wakes", appConfig.wakeInterval, appConfig.publishEveryN);
+  }
+
   addLogf("Device ID: %s", appConfig.deviceId);
   addLogf("Location: %.6f, %.6f", appConfig.latitude, appConfig.longitude);
 
   addLog("----------------");
 }
 
+// Sensor probing and warm-up run here while WiFi associates and NTP syncs
+void sensorInitTask(void *param) {
+  bootPhaseBegin(BOOT_SENSORS);
+
+  initSensors();
+  vTaskDelay(appConfig.sensorWarmupMs / portTICK_PERIOD_MS);
+
+  bootPhaseEnd(BOOT_SENSORS);
+  bootSetReady(BOOT_READY_SENSORS);
+
+  // Auto calibrate
+  if (appConfig.autoCalibrateOnBoot) startCalibration();
+
+  vTaskDelete(NULL);
+}
+
+// Live config changes (see configSubscribe); everything not listed here is
+// either read on use or needs a reboot
+void subscribeConfigChanges() {
+  configSubscribe(APPLY_SAMPLING, [](uint8_t) {
+    aggregatorReset();  // window length or sample rate changed
+    lastSend = millis();
+  });
+  configSubscribe(APPLY_MQTT, [](uint8_t) { mqttReconfigure(); });
+  configSubscribe(APPLY_CALIBRATION, [](uint8_t) { applyConfigToSensors(); });
+  configSubscribe(APPLY_TIME, [](uint8_t) { setupTime(); });
+  configSubscribe(APPLY_WIFI, [](uint8_t) { wifiReconnect(); });
+  configSubscribe(APPLY_SENSOR, [](uint8_t) { configureBME280(); });
+}
+
 void setup() {
   Serial.begin(115200);
+  bootProfilerInit();
+  bootPhaseBegin(BOOT_FIRST_SAMPLE);
   addLog("=== Starting ESP32 Weather Station ===");
 
+  bootPhaseBegin(BOOT_CONFIG);
   loadConfig();
   logAppConfig();
+  timebaseInit();
+  subscribeConfigChanges();
+  bootPhaseEnd(BOOT_CONFIG);
 
-  // WiFi
+  // Timer wakes go straight back through the duty cycle; a cold boot stays
+  // in normal mode for LOW_POWER_CONFIG_WINDOW so settings can be changed.
+  if (appConfig.lowPowerMode && lowPowerWokeFromSleep()) runLowPowerCycle();
+
+  // Sensors (task)
+  xTaskCreate(sensorInitTask, "SensorInit", 4096, NULL, 2, NULL);
+
+  // WiFi (async, completes in maintainWiFi())
+  bootPhaseBegin(BOOT_WIFI);
   setupWiFi();
 
   // Web server & OTA
+  bootPhaseBegin(BOOT_WEB);
   setupWebServer();
-  setupOTA();
+  bootPhaseEnd(BOOT_WEB);
 
-  // BME280
-  if (!bme.begin(0x76)) {
-    addLog("[ERROR] BME280 not found");
-    bmeInitialized = false;
-  } else {
-    bmeInitialized = true;
-    addLog("[INFO] BME280 initialized");
-  }
-
-  // Sensors
-  initDustSensor();
-  initMQ135();
-
-  // Auto calibrate
-  if (appConfig.autoCalibrateOnBoot) startCalibration();
+  bootPhaseBegin(BOOT_OTA);
+  setupOTA();
+  bootPhaseEnd(BOOT_OTA);
 
-  // Time sync
+  // Time sync (async, completes in the SNTP callback)
+  bootPhaseBegin(BOOT_NTP);
   setupTime();
 
-  // MQTT
-  if (appConfig.mqttEnabled) setupMQTT();  // only set server if enabled
+  // MQTT (may be enabled later from the settings page)
+  if (appConfig.mqttEnabled) bootPhaseBegin(BOOT_MQTT);
+  setupMQTT();  // only set server if enabled
+  loopMonitorInit();
+  loopMonitorEnableWatchdog();
+  heapMonitorInit();
   addLog("=== Setup Complete ===");
 }
 
 void loop() {
+  if (appConfig.lowPowerMode && millis() > LOW_POWER_CONFIG_WINDOW) {
+    addLog("[LP] Config window over, entering duty cycle");
+    runLowPowerCycle();
+  }
+
+  loopMonitorStart();
+
   maintainWiFi();
+  loopMonitorMark(LOOP_WIFI);
+
+  {
+    HEAP_SCOPE(HEAP_CONFIG);
+    configPersistLoop();
+    configApplyLoop();
+  }
+  loopMonitorMark(LOOP_CONFIG);
 
   // MQTT safe loop
-  loopMQTT();
+  {
+    HEAP_SCOPE(HEAP_MQTT);
+    loopMQTT();
+  }
+  loopMonitorMark(LOOP_MQTT);
 
   // OTA
   ArduinoOTA.handle();
+  loopMonitorMark(LOOP_OTA);
   ws.cleanupClients();
+  loopMonitorMark(LOOP_WS);
 
-  // Send sensor data
-  if (millis() - lastSend >= appConfig.sendInterval) {
-    latestJson = getDataJson();
+  // Send sensor data (gated on the sensor init task)
+  unsigned long sinceSend = millis() - lastSend;
+  if (bootIsReady(BOOT_READY_SENSORS) && sinceSend < appConfig.sendInterval) {
+    prepareSensors(appConfig.sendInterval - sinceSend);
+  }
+  if (bootIsReady(BOOT_READY_SENSORS) && sinceSend >= appConfig.sendInterval) {
+    SensorSample sample;
+    {
+      HEAP_SCOPE(HEAP_SAMPLE);
+      sample = readSensors();
+      TRACE_SCOPE(TR_SERIALIZE);
+      latestJson = sampleToJson(sample);
+    }
     notifyClients(latestJson);
-
-    if (appConfig.mqttEnabled) sendMQTT(latestJson);
+    bootPhaseEnd(BOOT_FIRST_SAMPLE);
+
+    // Raw samples stay local; upstream gets either every sample or window summaries
+    if (appConfig.mqttEnabled) {
+      if (appConfig.publishWindow == 0) {
+        sendMQTT(latestJson);
+      } else {
+        aggregatorAdd(sample);
+        if (aggregatorDue()) sendMQTT(aggregatorSummaryJson());
+      }
+    }
 
     lastSend = millis();
 
@@ -105,10 +198,13 @@ void loop() {
       lastSystemInfoSend = millis();
     }
   }
+  heapMonitorLoop();
+  loopMonitorMark(LOOP_SEND);
+  loopMonitorEnd();
 }
 
 void sendSystemInfoToClients() {
-  StaticJsonDocument<256> doc;
+  StaticJsonDocument<1024> doc;
 
   bool connected = WiFi.isConnected();
   const char* statusMsg = connected ? "WiFi Connected" : "Connecting...";
@@ -116,6 +212,27 @@ void sendSystemInfoToClients() {
   doc["status_msg"] = statusMsg;
   doc["uptime_seconds"] = millis() / 1000;
   doc["wifi_rssi"] = connected ? WiFi.RSSI() : 0;
+  doc["wifi_path"] = wifiLastConnectPath();
+  doc["wifi_connect_ms"] = wifiLastConnectMs();
+  wifiPathStatsJson(doc.createNestedObject("wifi_paths"));
+  doc["wifi_rssi_avg"] = wifiSmoothedRssi();
+  doc["wifi_roams"] = wifiRoamCount();
+  doc["wifi_down_ms"] = wifiDisconnectedMs();
+  doc["cfg_writes"] = configWritesSinceBoot();
+  doc["cfg_writes_total"] = configWritesLifetime();
+  doc["loop_p99_us"] = loopMonitorP99Us();
+  doc["loop_max_us"] = loopMonitorMaxUs();
+  doc["loop_stalls"] = loopMonitorStalls();
+  HeapSnapshot heap = heapSnapshot();
+  doc["heap_free"] = heap.freeBytes;
+  doc["heap_min"] = heap.minFree;
+  doc["heap_largest"] = heap.largest;
+  doc["heap_frag"] = roundf(heap.frag * 100.0f) / 100.0f;
+  JsonObject spikes = doc.createNestedObject("spikes");
+  for (uint8_t i = 0; i < CH_COUNT; i++) {
+    if (sampleChannels[i].spikeFloor > 0.0f) spikes[sampleChannels[i].key] = spikeCount(i);
+  }
+  SensorRegistry::sysinfo(doc.as<JsonObject>());
 
   String jsonString;
   serializeJson(doc, jsonString);
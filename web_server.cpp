@@ -10,6 +10,13 @@
 #include "config.h"  // appConfig
 #include "data.h"    // ws, server, onWsEvent, isWifiConnected
 #include "calibrate.h"
+#include "config_schema.h"
+#include "boot_profiler.h"
+#include "loop_monitor.h"
+#include "bench.h"
+#include "mqtt_handler.h"
+#include "heap_monitor.h"
+#include "trace.h"
 
 #include "settings_page.h"
 #include "dashboard_page.h"
@@ -35,6 +42,8 @@ void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
 }
 
 void notifyClients(String json) {
+  HEAP_SCOPE(HEAP_WS);
+  TRACE_SCOPE(TR_WS_BROADCAST);
   ws.textAll(json);
 }
 
@@ -42,16 +51,13 @@ void notifyClients(String json) {
 void handleReboot(AsyncWebServerRequest *request) {
   request->send(200, "text/html", "<html><body>Rebooting...</body></html>");
   addLog("Manual reboot requested. Restarting...");
-  delay(1000);
-  ESP.restart();
+  configRequestRestart();
 }
 
 void handleReset(AsyncWebServerRequest *request) {
   request->send(200, "text/html", "<html><body>Factory reset. Rebooting...</body></html>");
   addLog("Factory reset requested. Erasing NVS...");
   resetConfig();
-  delay(1000);
-  ESP.restart();
 }
 
 // ======== Send data to WebSocket ========
@@ -101,7 +107,10 @@ void setupWebServer() {
         addLogf("OTA Start: %s\n", filename.c_str());
         if (!Update.begin(UPDATE_SIZE_UNKNOWN)) Update.printError(Serial);
       }
-      if (len) Update.write(data, len);
+      if (len) {
+        TRACE_SCOPE(TR_OTA_CHUNK);
+        Update.write(data, len);
+      }
       if (final) {
         if (Update.end(true)) addLog("OTA Success!");
         else Update.printError(Serial);
@@ -137,37 +146,8 @@ void setupWebServer() {
 
   // Settings
   server.on("/settings", HTTP_GET, [](AsyncWebServerRequest *request) {
-    StaticJsonDocument<512> doc;
-    doc["deviceId"] = appConfig.deviceId;
-    doc["latitude"] = appConfig.latitude;
-    doc["longitude"] = appConfig.longitude;
-    doc["wifiSSID"] = appConfig.wifiSSID;
-    doc["wifiPass"] = appConfig.wifiPass;
-    doc["mqttServer"] = appConfig.mqttServer;
-    doc["mqttPort"] = appConfig.mqttPort;
-    doc["mqttUser"] = appConfig.mqttUser;
-    doc["mqttPass"] = appConfig.mqttPass;
-    doc["mqttTopic"] = appConfig.mqttTopic;
-    doc["mqttEnabled"] = appConfig.mqttEnabled;
-
-    doc["queueMaxSize"] = appConfig.queueMaxSize;
-    doc["queueFlushInterval"] = appConfig.queueFlushInterval;
-
-
-    doc["sendInterval"] = appConfig.sendInterval;
-    doc["ntpServer"] = appConfig.ntpServer;
-    doc["dustLEDPin"] = appConfig.dustLEDPin;
-    doc["dustADCPin"] = appConfig.dustADCPin;
-    doc["mqADCPin"] = appConfig.mqADCPin;
-    doc["mq_rl_kohm"] = appConfig.mq_rl_kohm;
-    doc["mq_r0_ratio_clean"] = appConfig.mq_r0_ratio_clean;
-
-    doc["mq_rzero"] = appConfig.mq_rzero;
-    doc["dust_baseline"] = appConfig.dust_baseline;
-    doc["dust_calibration"] = appConfig.dust_calibration;
-
-    doc["autoCalibrateOnBoot"] = appConfig.autoCalibrateOnBoot;
-
+    StaticJsonDocument<1536> doc;
+    configToJson(appConfig, doc.to<JsonObject>());
 
     String jsonConfig;
     serializeJson(doc, jsonConfig);
@@ -184,51 +164,38 @@ void setupWebServer() {
   server.on(
     "/save", HTTP_POST, [](AsyncWebServerRequest *request) {}, NULL,
     [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-      StaticJsonDocument<512> doc;
+      StaticJsonDocument<1536> doc;
       DeserializationError error = deserializeJson(doc, (const char *)data, len);
       if (error) {
         request->send(400, "text/plain", "Invalid JSON");
         return;
       }
 
-      if (doc.containsKey("deviceId")) strncpy(appConfig.deviceId, doc["deviceId"], sizeof(appConfig.deviceId));
-      if (doc.containsKey("latitude")) appConfig.latitude = doc["latitude"].as<float>();
-      if (doc.containsKey("longitude")) appConfig.longitude = doc["longitude"].as<float>();
-      if (doc.containsKey("wifiSSID")) strncpy(appConfig.wifiSSID, doc["wifiSSID"], sizeof(appConfig.wifiSSID));
-      if (doc.containsKey("wifiPass")) strncpy(appConfig.wifiPass, doc["wifiPass"], sizeof(appConfig.wifiPass));
-      if (doc.containsKey("mqttServer")) strncpy(appConfig.mqttServer, doc["mqttServer"], sizeof(appConfig.mqttServer));
-      if (doc.containsKey("mqttPort")) appConfig.mqttPort = doc["mqttPort"].as<uint16_t>();
-      if (doc.containsKey("mqttUser")) strncpy(appConfig.mqttUser, doc["mqttUser"], sizeof(appConfig.mqttUser));
-      if (doc.containsKey("mqttPass")) strncpy(appConfig.mqttPass, doc["mqttPass"], sizeof(appConfig.mqttPass));
-      if (doc.containsKey("mqttTopic")) strncpy(appConfig.mqttTopic, doc["mqttTopic"], sizeof(appConfig.mqttTopic));
-      if (doc.containsKey("mqttEnabled")) appConfig.mqttEnabled = doc["mqttEnabled"].as<bool>();
-
-      if (doc.containsKey("queueMaxSize")) appConfig.queueMaxSize = doc["queueMaxSize"].as<uint32_t>();
-      if (doc.containsKey("queueFlushInterval")) appConfig.queueFlushInterval = doc["queueFlushInterval"].as<uint16_t>();
-
-
-      if (doc.containsKey("sendInterval")) appConfig.sendInterval = doc["sendInterval"].as<uint32_t>();
-      if (doc.containsKey("ntpServer")) strncpy(appConfig.ntpServer, doc["ntpServer"], sizeof(appConfig.ntpServer));
-      if (doc.containsKey("mq_rl_kohm")) appConfig.mq_rl_kohm = doc["mq_rl_kohm"].as<float>();
-      if (doc.containsKey("mq_r0_ratio_clean")) appConfig.mq_r0_ratio_clean = doc["mq_r0_ratio_clean"].as<float>();
-      if (doc.containsKey("mq_rzero")) appConfig.mq_rzero = doc["mq_rzero"].as<float>();
-      if (doc.containsKey("dust_baseline")) appConfig.dust_baseline = doc["dust_baseline"].as<float>();
-      if (doc.containsKey("dust_calibration")) appConfig.dust_calibration = doc["dust_calibration"].as<float>();
-
-      if (doc.containsKey("autoCalibrateOnBoot")) appConfig.autoCalibrateOnBoot = doc["autoCalibrateOnBoot"].as<bool>();
-
-
-      if (doc.containsKey("dustLEDPin")) appConfig.dustLEDPin = doc["dustLEDPin"].as<uint8_t>();
-      if (doc.containsKey("dustADCPin")) appConfig.dustADCPin = doc["dustADCPin"].as<uint8_t>();
-      if (doc.containsKey("mqADCPin")) appConfig.mqADCPin = doc["mqADCPin"].as<uint8_t>();
-
-
+      AppConfig_t current;
+      configPending(current);
+      AppConfig_t next = current;
+      char badField[32];
+      if (!configFromJson(next, doc.as<JsonObjectConst>(), badField, sizeof(badField))) {
+        addLogf("[CFG] Rejected settings: invalid %s", badField);
+        request->send(400, "text/plain", String("Invalid value for ") + badField);
+        return;
+      }
 
-      saveConfig();
-      addLog("Configuration updated. Rebooting...");
-      request->send(200, "text/plain", "Settings saved. Rebooting...");
-      delay(1000);
-      ESP.restart();
+      StaticJsonDocument<1024> res;
+      JsonArray changed = res.createNestedArray("changed");
+      uint8_t mask = configDiff(current, next, &changed);
+      bool restart = mask & APPLY_RESTART;
+
+      // Assigned, saved and applied (or rebooted) by loop()
+      configSubmit(next, mask);
+
+      res["status"] = restart ? "restart" : "applied";
+      res["message"] = restart ? "Settings saved. Rebooting..."
+                       : changed.size() ? "Settings saved and applied."
+                                        : "No changes.";
+      String out;
+      serializeJson(res, out);
+      request->send(200, "application/json", out);
     });
 
 
@@ -238,6 +205,13 @@ void setupWebServer() {
   server.on("/reboot", HTTP_GET, handleReboot);
   server.on("/reset", HTTP_GET, handleReset);
   setupCalibrationRoutes();
+  setupBootRoutes();
+  setupLoopRoutes();
+  setupSensorRoutes();
+  setupBenchRoutes();
+  setupQueueRoutes();
+  setupHeapRoutes();
+  setupTraceRoutes();
 
   server.begin();
   String msg = "Web server started on http://";
@@ -2,135 +2,602 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
+#include <Preferences.h>
+#include <esp_netif.h>
+#include <lwip/dhcp.h>
 #include "data.h"
 #include "config.h"
+#include "boot_profiler.h"
+#include "trace.h"
+#include "timebase.h"
 
 bool isWifiConnected = false;
-unsigned long lastWiFiCheck = 0;
-const unsigned long wifiCheckInterval = 10000;  // 10s interval
 
 extern PubSubClient mqttClient;
 extern AppConfig_t appConfig;
 
+// Sampling does not wait for this; timestamps are resolved once SNTP syncs
 void setupTime() {
   configTime(3 * 3600, 0, appConfig.ntpServer);  // GMT+7
+  traceAsyncBegin(TR_NTP);
   addLog("[TIME] NTP configured");
 }
 
+// AP runs alongside STA (AP+STA) so the station keeps retrying in the background
 void startAP() {
+  if (WiFi.getMode() & WIFI_AP) return;
+
   addLog("[AP] Starting Access Point mode...");
   const char* apSSID = "ESP32-Weather-AP";
   const char* apPassword = "12345678";
 
+  WiFi.mode(WIFI_AP_STA);
   WiFi.softAP(apSSID, apPassword);
   addLogf("[AP] AP started. SSID: %s | IP: %s",
           apSSID, WiFi.softAPIP().toString().c_str());
-
-  isWifiConnected = false;
 }
 
-void connectToStrongestNode() {
+static void stopAP() {
+  if (!(WiFi.getMode() & WIFI_AP)) return;
+  WiFi.softAPdisconnect(true);
   WiFi.mode(WIFI_STA);
-  WiFi.disconnect(true);
-  delay(100);
+  addLog("[AP] Station connected, Access Point stopped");
+}
+
+// =====================================================================
+// Last good association cache
+// RTC_NOINIT memory survives resets and deep sleep, so the DHCP lease is
+// only reused on warm boots. BSSID/channel are mirrored to NVS for cold boots.
+// The lease is stamped on the boot-relative clock and reused only within
+// the same boot ID and until its renewal time (T1, half the lease); after
+// that the station goes back to DHCP so the server renews it.
+// =====================================================================
+#define WIFI_CACHE_MAGIC 0x57434632  // "WCF2"
+#define WIFI_CACHE_NAMESPACE "wifi_cache"
+
+struct WiFiCache {
+  uint32_t magic;
+  char ssid[32];
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint32_t ip, gateway, subnet, dns;
+  uint32_t leaseS;     // granted lease, 0 = unknown
+  uint32_t leaseBoot;  // bootId() when the lease was granted
+  uint64_t leaseAtUs;  // monoMicros() when the lease was granted
+  uint32_t checksum;
+};
+
+RTC_NOINIT_ATTR static WiFiCache rtcWiFiCache;
+static WiFiCache currentCache;    // what the current connect cycle started from
+static bool usingLease = false;   // on the cached static address, not DHCP
+
+static uint32_t wifiCacheChecksum(const WiFiCache& c) {
+  const uint8_t* p = (const uint8_t*)&c;
+  uint32_t h = 2166136261UL;  // FNV-1a
+  for (size_t i = 0; i < offsetof(WiFiCache, checksum); i++) h = (h ^ p[i]) * 16777619UL;
+  return h;
+}
+
+// Lease time the DHCP server granted, 0 if unknown
+static uint32_t dhcpLeaseSeconds() {
+  esp_netif_t* sta = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+  struct netif* nif = sta ? (struct netif*)esp_netif_get_netif_impl(sta) : nullptr;
+  struct dhcp* d = nif ? netif_dhcp_data(nif) : nullptr;
+  return (d && d->state == DHCP_STATE_BOUND) ? d->offered_t0_lease : 0;
+}
+
+// Before T1 the server still expects us to hold the address
+static bool leaseUsable(const WiFiCache& c) {
+  if (c.ip == 0 || c.leaseS == 0 || c.leaseBoot != bootId()) return false;
+  return monoMicros() - c.leaseAtUs < (uint64_t)c.leaseS * 1000000ULL / 2;
+}
+
+static bool rtcCacheValid() {
+  return rtcWiFiCache.magic == WIFI_CACHE_MAGIC && rtcWiFiCache.checksum == wifiCacheChecksum(rtcWiFiCache) && strncmp(rtcWiFiCache.ssid, appConfig.wifiSSID, sizeof(rtcWiFiCache.ssid)) == 0;
+}
 
-  addLogf("[WiFi] Scanning for SSID '%s'...", appConfig.wifiSSID);
+// BSSID/channel from RTC, else from NVS (without lease). Returns false if nothing cached.
+static bool loadWiFiCache(WiFiCache& out, bool& hasLease) {
+  if (rtcCacheValid()) {
+    out = rtcWiFiCache;
+    hasLease = leaseUsable(out);
+    return true;
+  }
 
-  int n = WiFi.scanNetworks(false, true);  // include hidden networks, get BSSID
-  if (n <= 0) {
-    addLog("[WiFi] No networks found");
-    startAP();
+  hasLease = false;
+  Preferences prefs;
+  prefs.begin(WIFI_CACHE_NAMESPACE, true);
+  bool ok = prefs.getBytesLength("last") == sizeof(WiFiCache) && prefs.getBytes("last", &out, sizeof(WiFiCache)) == sizeof(WiFiCache);
+  prefs.end();
+
+  if (!ok || out.magic != WIFI_CACHE_MAGIC || strncmp(out.ssid, appConfig.wifiSSID, sizeof(out.ssid)) != 0) return false;
+  out.ip = out.gateway = out.subnet = out.dns = 0;
+  return true;
+}
+
+static void saveWiFiCache() {
+  WiFiCache c = {};
+  c.magic = WIFI_CACHE_MAGIC;
+  strncpy(c.ssid, appConfig.wifiSSID, sizeof(c.ssid));
+  memcpy(c.bssid, WiFi.BSSID(), 6);
+  c.channel = WiFi.channel();
+  c.ip = WiFi.localIP();
+  c.gateway = WiFi.gatewayIP();
+  c.subnet = WiFi.subnetMask();
+  c.dns = WiFi.dnsIP();
+  if (usingLease) {
+    // Still on the cached address: keep its original grant time
+    c.leaseS = currentCache.leaseS;
+    c.leaseBoot = currentCache.leaseBoot;
+    c.leaseAtUs = currentCache.leaseAtUs;
+  } else {
+    c.leaseS = dhcpLeaseSeconds();
+    c.leaseBoot = bootId();
+    c.leaseAtUs = monoMicros();
+  }
+  c.checksum = wifiCacheChecksum(c);
+
+  bool apChanged = !rtcCacheValid() || memcmp(rtcWiFiCache.bssid, c.bssid, 6) != 0 || rtcWiFiCache.channel != c.channel;
+  rtcWiFiCache = c;
+
+  // Only touch flash when the AP changes
+  if (apChanged) {
+    Preferences prefs;
+    prefs.begin(WIFI_CACHE_NAMESPACE, false);
+    prefs.putBytes("last", &c, sizeof(WiFiCache));
+    prefs.end();
+  }
+}
+
+// =====================================================================
+// Connect paths: cached BSSID -> single-channel scan -> full scan
+// =====================================================================
+enum WiFiConnectPath : uint8_t { PATH_CACHED, PATH_CHANNEL_SCAN, PATH_FULL_SCAN, PATH_ROAM, PATH_COUNT };
+
+static const char* const wifiPathNames[PATH_COUNT] = { "cached", "channel_scan", "full_scan", "roam" };
+
+struct WiFiPathStats {
+  uint32_t attempts;
+  uint32_t successes;
+  uint32_t lastMs;
+};
+
+static WiFiPathStats wifiPathStats[PATH_COUNT];
+static int8_t lastConnectPath = -1;
+static uint32_t lastConnectMs = 0;
+
+const char* wifiLastConnectPath() {
+  return lastConnectPath < 0 ? "none" : wifiPathNames[lastConnectPath];
+}
+
+uint32_t wifiLastConnectMs() {
+  return lastConnectMs;
+}
+
+void wifiPathStatsJson(JsonObject obj) {
+  for (uint8_t i = 0; i < PATH_COUNT; i++) {
+    JsonObject o = obj.createNestedObject(wifiPathNames[i]);
+    o["attempts"] = wifiPathStats[i].attempts;
+    o["ok"] = wifiPathStats[i].successes;
+    o["last_ms"] = wifiPathStats[i].lastMs;
+  }
+}
+
+// =====================================================================
+// Connection state machine
+// WiFi events only raise flags (they run in the WiFi task); all transitions
+// happen in maintainWiFi() so loop() never blocks on association or scans.
+// =====================================================================
+enum WiFiState : uint8_t {
+  WIFI_STATE_IDLE,
+  WIFI_STATE_CONNECTING,
+  WIFI_STATE_SCANNING,
+  WIFI_STATE_CONNECTED,
+  WIFI_STATE_ROAM_LEAVING,  // disconnected from the old AP, waiting for the event
+  WIFI_STATE_BACKOFF
+};
+
+#define WIFI_CACHED_TIMEOUT_MS 4000
+#define WIFI_SCAN_CONNECT_TIMEOUT_MS 15000
+#define WIFI_SCAN_TIMEOUT_MS 10000
+#define WIFI_RETRY_MIN_MS 5000
+#define WIFI_RETRY_MAX_MS 60000
+#define WIFI_DISCONNECT_SETTLE_MS 300  // ignore stale disconnect events right after begin()
+
+static WiFiState wifiState = WIFI_STATE_IDLE;
+static WiFiConnectPath currentPath = PATH_CACHED;
+static unsigned long stateSince = 0;
+static unsigned long stateTimeout = 0;
+static unsigned long cycleStartedAt = 0;
+static unsigned long retryDelay = WIFI_RETRY_MIN_MS;
+
+static bool haveCache = false;
+
+// --- Roaming ---
+#define ROAM_RSSI_SAMPLE_MS 2000
+#define ROAM_RSSI_THRESHOLD -70      // dBm (smoothed) below which we look for a better AP
+#define ROAM_LATENCY_THRESHOLD_US 250000
+#define ROAM_HYSTERESIS_DB 8         // candidate must beat the current AP by this much
+#define ROAM_SCAN_INTERVAL_MS 60000
+#define ROAM_LEAVE_TIMEOUT_MS 1000   // max wait for the old AP's disconnect event
+
+static float rssiAvg = NAN;
+static float publishLatencyAvg = NAN;  // µs
+static unsigned long lastRssiSample = 0;
+static unsigned long lastRoamScan = 0;
+static bool roamScanRunning = false;
+static uint32_t roamCount = 0;
+static uint8_t roamBssid[6];
+static int32_t roamChannel = 0;
+
+static unsigned long disconnectedSince = 0;
+static uint32_t totalDisconnectedMs = 0;
+static uint32_t lastOutageMs = 0;
+
+static volatile bool evGotIp = false;
+static volatile bool evDisconnected = false;
+static volatile bool evScanDone = false;
+static volatile uint8_t evDisconnectReason = 0;
+static uint8_t evDisconnectBssid[6];
+
+// Current attempt: target AP, and whether the old link was still up at begin()
+static uint8_t targetBssid[6];
+static bool attemptWhileLinked = false;
+
+static void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      evGotIp = true;
+      break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      evDisconnectReason = info.wifi_sta_disconnected.reason;
+      memcpy(evDisconnectBssid, info.wifi_sta_disconnected.bssid, 6);
+      evDisconnected = true;
+      break;
+    case ARDUINO_EVENT_WIFI_SCAN_DONE:
+      evScanDone = true;
+      break;
+    default:
+      break;
+  }
+}
+
+static void enterState(WiFiState state, unsigned long timeoutMs) {
+  wifiState = state;
+  stateSince = millis();
+  stateTimeout = timeoutMs;
+}
+
+static void beginConnect(WiFiConnectPath path, int32_t channel, const uint8_t* bssid, unsigned long timeoutMs) {
+  currentPath = path;
+  wifiPathStats[path].attempts++;
+  evDisconnected = false;
+  evGotIp = false;
+  attemptWhileLinked = WiFi.status() == WL_CONNECTED;
+  if (bssid) memcpy(targetBssid, bssid, 6);
+  else memset(targetBssid, 0, 6);
+  WiFi.begin(appConfig.wifiSSID, appConfig.wifiPass, channel, bssid);
+  enterState(WIFI_STATE_CONNECTING, timeoutMs);
+}
+
+static void beginScan(WiFiConnectPath path) {
+  currentPath = path;
+  evScanDone = false;
+  WiFi.disconnect();
+
+  int16_t rc;
+  if (path == PATH_CHANNEL_SCAN) {
+    addLogf("[WiFi] Scanning ch %d for SSID '%s'...", currentCache.channel, appConfig.wifiSSID);
+    rc = WiFi.scanNetworks(true, false, false, 120, currentCache.channel, appConfig.wifiSSID);
+  } else {
+    addLogf("[WiFi] Scanning for SSID '%s'...", appConfig.wifiSSID);
+    rc = WiFi.scanNetworks(true, true);  // include hidden networks
+  }
+
+  if (rc == WIFI_SCAN_FAILED) addLog("[WiFi] Scan could not be started");
+  else traceAsyncBegin(TR_WIFI_SCAN);
+  enterState(WIFI_STATE_SCANNING, WIFI_SCAN_TIMEOUT_MS);
+}
+
+// Start a new connect cycle: cached BSSID -> single-channel scan -> full scan
+static void startConnectCycle() {
+  cycleStartedAt = millis();
+  WiFi.mode((WiFi.getMode() & WIFI_AP) ? WIFI_AP_STA : WIFI_STA);
+
+  haveCache = loadWiFiCache(currentCache, usingLease);
+  if (haveCache) {
+    addLogf("[WiFi] Fast reconnect to cached BSSID on ch %d%s", currentCache.channel, usingLease ? " with cached lease" : "");
+    if (usingLease) WiFi.config(IPAddress(currentCache.ip), IPAddress(currentCache.gateway), IPAddress(currentCache.subnet), IPAddress(currentCache.dns));
+    beginConnect(PATH_CACHED, currentCache.channel, currentCache.bssid, WIFI_CACHED_TIMEOUT_MS);
+  } else {
+    beginScan(PATH_FULL_SCAN);
+  }
+}
+
+static void cycleFailed() {
+  addLogf("[WiFi] Connection failed, retrying in %lu s", retryDelay / 1000);
+  startAP();
+  enterState(WIFI_STATE_BACKOFF, retryDelay);
+  retryDelay = min(retryDelay * 2, (unsigned long)WIFI_RETRY_MAX_MS);
+}
+
+static void leaveCachedLease() {
+  WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));  // back to DHCP
+  usingLease = false;
+}
+
+static void attemptFailed() {
+  addLogf("[WiFi] %s path failed (reason %u)", wifiPathNames[currentPath], evDisconnectReason);
+  WiFi.disconnect();
+
+  // Failed roam: start over, the cache still points at the previous AP
+  if (currentPath == PATH_ROAM) {
+    startConnectCycle();
     return;
   }
 
-  addLogf("[WiFi] Found %d networks:", n);
+  if (currentPath == PATH_CACHED && usingLease) leaveCachedLease();
 
-  // Print all scanned networks
-  for (int i = 0; i < n; i++) {
-    addLogf(
-      "  %02d) SSID=%s | BSSID=%s | RSSI=%d",
-      i + 1,
-      WiFi.SSID(i).c_str(),
-      WiFi.BSSIDstr(i).c_str(),
-      WiFi.RSSI(i)
-    );
+  if (currentPath == PATH_CACHED) beginScan(PATH_CHANNEL_SCAN);
+  else if (currentPath == PATH_CHANNEL_SCAN) beginScan(PATH_FULL_SCAN);
+  else cycleFailed();
+}
+
+static void connected() {
+  uint32_t ms = millis() - cycleStartedAt;
+  wifiPathStats[currentPath].successes++;
+  wifiPathStats[currentPath].lastMs = ms;
+  lastConnectPath = currentPath;
+  lastConnectMs = ms;
+
+  if (disconnectedSince != 0) {
+    lastOutageMs = millis() - disconnectedSince;
+    totalDisconnectedMs += lastOutageMs;
+    disconnectedSince = 0;
   }
+  if (currentPath == PATH_ROAM) {
+    addLogf("[ROAM] Roam #%u complete, %lu ms without connectivity", roamCount, lastOutageMs);
+  }
+
+  addLogf("[WiFi] Connected via %s in %lu ms (BSSID %s, ch %d)",
+          wifiPathNames[currentPath], ms, WiFi.BSSIDstr().c_str(), WiFi.channel());
+  addLogf("IP: %s", WiFi.localIP().toString().c_str());
 
-  int32_t bestRSSI = -999;
-  String bestBSSIDStr = "";
+  saveWiFiCache();
+  stopAP();
+  isWifiConnected = true;
+  bootPhaseEnd(BOOT_WIFI);
+  bootSetReady(BOOT_READY_WIFI);
+  retryDelay = WIFI_RETRY_MIN_MS;
+  rssiAvg = NAN;
+  publishLatencyAvg = NAN;
+  roamScanRunning = false;
+  enterState(WIFI_STATE_CONNECTED, 0);
+}
 
-  // Find strongest BSSID with matching SSID
+// Strongest scan result matching the configured SSID, -1 if none
+static int findStrongestMatch(int n) {
+  int best = -1;
   for (int i = 0; i < n; i++) {
-    if (WiFi.SSID(i) == appConfig.wifiSSID) {
-      int32_t rssi = WiFi.RSSI(i);
-      String bssid = WiFi.BSSIDstr(i);
-
-      addLogf("[MATCH] SSID=%s | BSSID=%s | RSSI=%d",
-              appConfig.wifiSSID,
-              bssid.c_str(),
-              rssi);
-
-      if (rssi > bestRSSI) {
-        bestRSSI = rssi;
-        bestBSSIDStr = bssid;
-      }
-    }
+    if (WiFi.SSID(i) != appConfig.wifiSSID) continue;
+
+    addLogf("[MATCH] SSID=%s | BSSID=%s | RSSI=%d | ch %d",
+            appConfig.wifiSSID, WiFi.BSSIDstr(i).c_str(), WiFi.RSSI(i), WiFi.channel(i));
+
+    if (best < 0 || WiFi.RSSI(i) > WiFi.RSSI(best)) best = i;
   }
+  return best;
+}
 
-  if (bestBSSIDStr.isEmpty()) {
-    addLog("[WiFi] Target SSID not found");
-    startAP();
+static void scanFinished() {
+  int n = WiFi.scanComplete();
+  if (n == WIFI_SCAN_RUNNING) return;
+  traceAsyncEnd(TR_WIFI_SCAN);
+
+  int best = n > 0 ? findStrongestMatch(n) : -1;
+  if (best < 0) {
+    addLogf("[WiFi] %s: target SSID not found (%d networks)", wifiPathNames[currentPath], n);
+    WiFi.scanDelete();
+    if (currentPath == PATH_CHANNEL_SCAN) beginScan(PATH_FULL_SCAN);
+    else cycleFailed();
     return;
   }
 
-  // Parse BSSID string → uint8_t array
-  uint8_t bestBSSID[6];
-  sscanf(bestBSSIDStr.c_str(),
-         "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
-         &bestBSSID[0], &bestBSSID[1], &bestBSSID[2],
-         &bestBSSID[3], &bestBSSID[4], &bestBSSID[5]);
+  uint8_t bssid[6];
+  memcpy(bssid, WiFi.BSSID(best), 6);
+  int32_t channel = WiFi.channel(best);
+
+  addLogf("[WiFi] Best match: %s (RSSI %d)", WiFi.BSSIDstr(best).c_str(), WiFi.RSSI(best));
+  WiFi.scanDelete();
 
-  addLogf("[WiFi] Best match: %s (RSSI %d)",
-          bestBSSIDStr.c_str(),
-          bestRSSI);
+  beginConnect(currentPath, channel, bssid, WIFI_SCAN_CONNECT_TIMEOUT_MS);
+}
 
-  addLogf("[WiFi] Connecting to BSSID %s...", bestBSSIDStr.c_str());
-  WiFi.begin(appConfig.wifiSSID, appConfig.wifiPass, 0, bestBSSID);
+// =====================================================================
+// Background roaming: watch RSSI / publish latency, scan the target SSID
+// opportunistically and switch BSSID only when a clearly better AP exists
+// =====================================================================
+void wifiRecordPublishLatency(uint32_t us) {
+  publishLatencyAvg = isfinite(publishLatencyAvg) ? publishLatencyAvg * 0.8f + us * 0.2f : us;
+}
 
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 30) {
-    delay(500);
-    attempts++;
+static void roamCheck(unsigned long now) {
+  if (now - lastRssiSample >= ROAM_RSSI_SAMPLE_MS) {
+    lastRssiSample = now;
+    int8_t rssi = WiFi.RSSI();
+    rssiAvg = isfinite(rssiAvg) ? rssiAvg * 0.75f + rssi * 0.25f : rssi;
   }
 
-  if (WiFi.status() == WL_CONNECTED) {
-    addLog("[WiFi] Connected");
-    addLogf("IP: %s", WiFi.localIP().toString().c_str());
-    isWifiConnected = true;
-  } else {
-    addLog("[WiFi] Connection failed");
-    startAP();
+  if (roamScanRunning || !isfinite(rssiAvg)) return;
+  if (now - lastRoamScan < ROAM_SCAN_INTERVAL_MS) return;
+
+  bool weakSignal = rssiAvg < ROAM_RSSI_THRESHOLD;
+  bool slowPublish = isfinite(publishLatencyAvg) && publishLatencyAvg > ROAM_LATENCY_THRESHOLD_US;
+  if (!weakSignal && !slowPublish) return;
+
+  lastRoamScan = now;
+  evScanDone = false;
+  if (WiFi.scanNetworks(true, false, false, 120, 0, appConfig.wifiSSID) == WIFI_SCAN_FAILED) return;
+
+  roamScanRunning = true;
+  traceAsyncBegin(TR_WIFI_SCAN);
+  addLogf("[ROAM] Background scan (RSSI %.0f dBm, publish %.0f ms)", rssiAvg, isfinite(publishLatencyAvg) ? publishLatencyAvg / 1000.0f : 0.0f);
+}
+
+static void roamScanFinished() {
+  roamScanRunning = false;
+  traceAsyncEnd(TR_WIFI_SCAN);
+  int n = WiFi.scanComplete();
+
+  uint8_t current[6];
+  memcpy(current, WiFi.BSSID(), 6);
+
+  int best = -1;
+  for (int i = 0; i < n; i++) {
+    if (WiFi.SSID(i) != appConfig.wifiSSID) continue;
+    if (memcmp(WiFi.BSSID(i), current, 6) == 0) continue;
+    if (best < 0 || WiFi.RSSI(i) > WiFi.RSSI(best)) best = i;
+  }
+
+  if (best < 0 || WiFi.RSSI(best) < rssiAvg + ROAM_HYSTERESIS_DB) {
+    WiFi.scanDelete();
+    return;
   }
+
+  memcpy(roamBssid, WiFi.BSSID(best), 6);
+  roamChannel = WiFi.channel(best);
+
+  roamCount++;
+  addLogf("[ROAM] Roam #%u: %s (%.0f dBm) -> %s (%d dBm, ch %d)",
+          roamCount, WiFi.BSSIDstr().c_str(), rssiAvg,
+          WiFi.BSSIDstr(best).c_str(), WiFi.RSSI(best), roamChannel);
+  WiFi.scanDelete();
+
+  // The driver will not join another AP while associated: leave the old
+  // one first and connect once its disconnect event is in
+  isWifiConnected = false;
+  disconnectedSince = millis();
+  cycleStartedAt = disconnectedSince;
+  evDisconnected = false;
+  evGotIp = false;
+  WiFi.disconnect();
+  enterState(WIFI_STATE_ROAM_LEAVING, ROAM_LEAVE_TIMEOUT_MS);
+}
+
+int wifiSmoothedRssi() {
+  return isfinite(rssiAvg) ? (int)lroundf(rssiAvg) : 0;
+}
+
+uint32_t wifiRoamCount() {
+  return roamCount;
+}
+
+uint32_t wifiDisconnectedMs() {
+  return totalDisconnectedMs + (disconnectedSince ? millis() - disconnectedSince : 0);
 }
 
+// A disconnect reported for another AP than the one being joined
+static bool staleDisconnect() {
+  static const uint8_t none[6] = { 0 };
+  if (memcmp(targetBssid, none, 6) == 0 || memcmp(evDisconnectBssid, none, 6) == 0) return false;
+  return memcmp(evDisconnectBssid, targetBssid, 6) != 0;
+}
 
 void maintainWiFi() {
   unsigned long now = millis();
-  if (now - lastWiFiCheck < wifiCheckInterval) return;
-  lastWiFiCheck = now;
+  bool timedOut = stateTimeout > 0 && now - stateSince >= stateTimeout;
 
-  if (WiFi.getMode() & WIFI_AP) {
-    addLog("[WiFi] In AP mode, will retry STA later");
-    return;
+  switch (wifiState) {
+    case WIFI_STATE_IDLE:
+      break;
+
+    case WIFI_STATE_CONNECTING:
+      if (evDisconnected && (now - stateSince < WIFI_DISCONNECT_SETTLE_MS || staleDisconnect())) {
+        evDisconnected = false;  // from the previous link, not this attempt
+      }
+      // Right after begin() the status can still report the old link
+      if (evGotIp || (!attemptWhileLinked && WiFi.status() == WL_CONNECTED)) {
+        evGotIp = false;
+        connected();
+      } else if (evDisconnected) {
+        evDisconnected = false;
+        attemptFailed();
+      } else if (timedOut) {
+        attemptFailed();
+      }
+      break;
+
+    case WIFI_STATE_SCANNING:
+      if (evScanDone || WiFi.scanComplete() >= 0) {
+        evScanDone = false;
+        scanFinished();
+      } else if (timedOut) {
+        addLog("[WiFi] Scan timed out");
+        traceAsyncEnd(TR_WIFI_SCAN);
+        WiFi.scanDelete();
+        cycleFailed();
+      }
+      break;
+
+    case WIFI_STATE_CONNECTED:
+      if (evDisconnected || WiFi.status() != WL_CONNECTED) {
+        evDisconnected = false;
+        isWifiConnected = false;
+        disconnectedSince = now;
+        if (roamScanRunning) WiFi.scanDelete();
+        roamScanRunning = false;
+        addLogf("[WiFi] Lost connection (reason %u), reconnecting...", evDisconnectReason);
+        startConnectCycle();
+      } else if (evGotIp) {
+        // DHCP bound or renewed: cache the new lease
+        evGotIp = false;
+        saveWiFiCache();
+      } else if (usingLease && !leaseUsable(currentCache)) {
+        addLog("[WiFi] Cached lease due for renewal, switching to DHCP");
+        leaveCachedLease();
+      } else if (roamScanRunning && (evScanDone || WiFi.scanComplete() >= 0)) {
+        evScanDone = false;
+        roamScanFinished();
+      } else {
+        roamCheck(now);
+      }
+      break;
+
+    case WIFI_STATE_ROAM_LEAVING:
+      if (evDisconnected || timedOut) {
+        evDisconnected = false;
+        beginConnect(PATH_ROAM, roamChannel, roamBssid, WIFI_SCAN_CONNECT_TIMEOUT_MS);
+      }
+      break;
+
+    case WIFI_STATE_BACKOFF:
+      if (timedOut) startConnectCycle();
+      break;
   }
+}
 
-  if (WiFi.status() != WL_CONNECTED) {
-    addLog("[WiFi] Lost connection, reconnecting...");
-    connectToStrongestNode();
+// Drop the current association and start over with the new credentials
+void wifiReconnect() {
+  addLogf("[WiFi] Credentials changed, reconnecting to %s", appConfig.wifiSSID);
+  if (wifiState == WIFI_STATE_SCANNING || roamScanRunning) WiFi.scanDelete();
+  roamScanRunning = false;
+  if (isWifiConnected) {
+    isWifiConnected = false;
+    disconnectedSince = millis();
   }
+  WiFi.disconnect();
+  evGotIp = evDisconnected = evScanDone = false;
+  retryDelay = WIFI_RETRY_MIN_MS;
+  startConnectCycle();
 }
 
 void setupWiFi() {
-  connectToStrongestNode();
+  static bool eventsRegistered = false;
+  WiFi.persistent(false);
+  WiFi.setAutoReconnect(false);  // reconnects are driven by maintainWiFi()
+  if (!eventsRegistered) {
+    WiFi.onEvent(onWiFiEvent);
+    eventsRegistered = true;
+  }
+  startConnectCycle();
 }
-